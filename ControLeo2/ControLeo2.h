@@ -2,6 +2,8 @@
 //  - LCD display and backlight
 //  - Buzzer
 //  - Thermocouple
+//  - Fast number formatting for the LCD and serial port
+//  - Reflow engine (phase tables and output switching)
 
 // Written by Peter Easton
 // Released under WTFPL license
@@ -14,6 +16,8 @@
 
 #include "ControLeo2_LiquidCrystal.h"
 #include "ControLeo2_MAX31855.h"
+#include "ControLeo2_Format.h"
+#include "ControLeo2_ReflowEngine.h"
 
 
 // Defines for the 2 buttons
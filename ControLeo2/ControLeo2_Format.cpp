@@ -0,0 +1,86 @@
+// Fast number formatting for the LCD display and serial port
+//
+// Printing a double using lcd.print() or Serial.print() is slow because Arduino's
+// Print::printFloat does a floating point multiply and divide for every digit.  It also
+// prints a variable number of characters, so the previous value needs to be blanked out.
+// Instead, convert the value to fixed point once and format it here using integer math.
+// The result is right-aligned in a fixed-width field so it always overwrites the old value.
+//
+// Written by agent
+// Released under WTFPL license
+//
+// Change History:
+// 18 October 2026       Initial Version
+
+#include	"ControLeo2_Format.h"
+
+
+/*******************************************************************************
+* Name: formatNumber
+* Description:  Format an integer or fixed-point number into a buffer, right-aligned
+*               and padded with spaces to the given width.
+*
+* Argument  	Description
+* =========  	===========
+* 1. buffer   	Where to write the number.  Must hold at least width+1 characters,
+*               and FORMAT_MAX_DIGITS+1 characters if width is 0
+* 2. value    	The number to format.  For fixed point numbers this is scaled by
+*               10^decimals, so 12345 with 2 decimals is 123.45
+* 3. width    	The number of characters to write.  0 means no padding
+* 4. decimals 	The number of digits after the decimal point (up to FORMAT_MAX_DECIMALS)
+*
+* Return        Description
+* =========		===========
+* buffer        The buffer, containing the 0-terminated string.  If the number doesn't
+*               fit in the width then the buffer is filled with '*'.
+*				
+*******************************************************************************/
+char *formatNumber(char *buffer, long value, uint8_t width, uint8_t decimals)
+{
+	char digits[FORMAT_MAX_DIGITS];
+	uint8_t len = 0, i = 0;
+	// Negating LONG_MIN overflows a long, but not an unsigned long
+	unsigned long number = (value < 0)? 0UL - (unsigned long) value : value;
+	
+	// A (32-bit) long has up to 10 digits.  With up to 9 decimals, the digits, decimal point and
+	// sign always fit in FORMAT_MAX_DIGITS
+	if (decimals > FORMAT_MAX_DECIMALS)
+		decimals = FORMAT_MAX_DECIMALS;
+	
+	// Generate the digits, least significant first
+	do {
+		if (decimals && len == decimals)
+			digits[len++] = '.';
+		// 16-bit division is much faster than 32-bit division on the AVR
+		if (number <= 0xFFFF) {
+			uint16_t number16 = number;
+			digits[len++] = '0' + number16 % 10;
+			number = number16 / 10;
+		}
+		else {
+			digits[len++] = '0' + number % 10;
+			number /= 10;
+		}
+	} while (number || len <= decimals);
+	
+	// Make room for the sign
+	if (value < 0)
+		digits[len++] = '-';
+	
+	// Does the number fit?
+	if (width && len > width) {
+		while (i < width)
+			buffer[i++] = '*';
+		buffer[i] = 0;
+		return buffer;
+	}
+	
+	// Pad with spaces, then copy the digits in the right order
+	while (i + len < width)
+		buffer[i++] = ' ';
+	while (len)
+		buffer[i++] = digits[--len];
+	buffer[i] = 0;
+	
+	return buffer;
+}
@@ -0,0 +1,19 @@
+// Written by agent
+// Released under WTFPL license
+//
+// Change History:
+// 18 October 2026       Initial Version
+
+#ifndef CONTROLEO2_FORMAT_H
+#define CONTROLEO2_FORMAT_H
+
+#include <inttypes.h>
+
+// Maximum number of characters written by formatNumber (not including the terminating 0)
+#define FORMAT_MAX_DIGITS   12
+// Maximum number of digits after the decimal point.  More than this are treated as this many
+#define FORMAT_MAX_DECIMALS 9
+
+char	*formatNumber(char *buffer, long value, uint8_t width, uint8_t decimals = 0);
+
+#endif  // CONTROLEO2_FORMAT_H
@@ -11,6 +11,7 @@
 //
 // Change History:
 // 14 August 2014        Initial Version
+// 18 October 2026       setCursor() puts rows past the bottom of the display on the last row
 
 #include <stdio.h>
 #include <string.h>
@@ -133,7 +134,7 @@ void ControLeo2_LiquidCrystal::home()
 void ControLeo2_LiquidCrystal::setCursor(uint8_t col, uint8_t row)
 {
     int row_offsets[] = {0x00, 0x40, 0x14, 0x54};
-    if (row > _numlines) {
+    if (row >= _numlines) {
         row = _numlines - 1;    // Count rows starting with 0
     }
     command(LCD_SETDDRAMADDR | (col + row_offsets[row]));
@@ -7,31 +7,34 @@
 // MISO - D8
 // SCK  - D9
 // CS   - D10
+// Additional MAX31855's can be connected to MISO and SCK, each with its own CS pin.
 //
 // Written by Peter Easton
 // Released under WTFPL license
 //
 // Change History:
 // 14 August 2014        Initial Version
+// 18 October 2026       Support multiple MAX31855's sharing MISO and CLK
 
 #include	"ControLeo2_MAX31855.h"
 
 #define MISO_PIN    8
-#define CS_PIN      9
 #define CLK_PIN     10
 
 
-ControLeo2_MAX31855::ControLeo2_MAX31855(void)
+ControLeo2_MAX31855::ControLeo2_MAX31855(uint8_t csPin)
 {
+	_cs_pin = csPin;
+
 	// MAX31855 data output pin
 	pinMode(MISO_PIN, INPUT);
 	// MAX31855 chip select input pin
-	pinMode(CS_PIN, OUTPUT);
+	pinMode(_cs_pin, OUTPUT);
 	// MAX31855 clock input pin
 	pinMode(CLK_PIN, OUTPUT);
  
 	// Default output pins state
-	digitalWrite(CS_PIN, HIGH);
+	digitalWrite(_cs_pin, HIGH);
 	digitalWrite(CLK_PIN, LOW);
 }
 
@@ -202,7 +205,7 @@ unsigned long ControLeo2_MAX31855::readData()
 	data = 0;
 
 	// Select the MAX31855 chip
-	digitalWrite(CS_PIN, LOW);
+	digitalWrite(_cs_pin, LOW);
 	
 	// Shift in 32-bit of data
 	for (bitCount = 31; bitCount >= 0; bitCount--)
@@ -221,7 +224,7 @@ unsigned long ControLeo2_MAX31855::readData()
 	}
 	
 	// Deselect MAX31855 chip
-	digitalWrite(CS_PIN, HIGH);
+	digitalWrite(_cs_pin, HIGH);
 	
 	return(data);
 }
\ No newline at end of file
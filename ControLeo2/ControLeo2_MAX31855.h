@@ -3,6 +3,7 @@
 //
 // Change History:
 // 14 August 2014        Initial Version
+// 18 October 2026       Support multiple MAX31855's sharing MISO and CLK
 
 #ifndef CONTROLEO2_MAX31855_H
 #define CONTROLEO2_MAX31855_H
@@ -13,6 +14,10 @@
 #define	FAULT_SHORT_GND	10001
 #define	FAULT_SHORT_VCC	10002
 
+// The chip select used by the MAX31855 on the ControLeo2 board.  Additional MAX31855's
+// can share MISO and CLK, but each needs its own chip select pin
+#define	MAX31855_DEFAULT_CS_PIN	9
+
 enum	unit_t
 {
 	CELSIUS,
@@ -22,12 +27,14 @@ enum	unit_t
 class	ControLeo2_MAX31855
 {
 public:
-    ControLeo2_MAX31855(void);
+    ControLeo2_MAX31855(uint8_t csPin = MAX31855_DEFAULT_CS_PIN);
 	
     double	readThermocouple(unit_t	unit);
     double	readJunction(unit_t	unit);
     
 private:
     unsigned long readData();
+
+    uint8_t _cs_pin;        // Chip select for this MAX31855
 };
 #endif  // CONTROLEO2_MAX31855_H
\ No newline at end of file
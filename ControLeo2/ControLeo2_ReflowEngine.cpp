@@ -0,0 +1,264 @@
+// Table-driven reflow engine
+//
+// A reflow profile is a list of phases.  Each phase has an exit temperature, a minimum
+// and maximum duration and a level for each of the outputs D4 to D7.  The engine keeps
+// track of the current phase, decides when to move to the next one and switches the
+// outputs on and off to match their levels.  Anything that needs the LCD, the serial
+// port or the EEPROM is left to the sketch, which acts on the events returned by tick().
+//
+// Phase tables are normally kept in flash.  Only the current phase is copied into RAM.
+// Sketches that build their phases at run time (for example, from settings) can supply
+// a phase loader instead of a table, and an output level hook can change an output's
+// level on the fly (for example, full power until the oven warms up).
+//
+// tick() does a fixed amount of work, never waits and never prints, so it is safe to
+// call as often as the sketch likes.
+//
+// Written by agent
+// Based on the reflow code in the ReflowWizard sketch by Peter Easton and the ReflowOven2
+// sketch by Keith Rome
+// Released under WTFPL license
+//
+// Change History:
+// 18 October 2026       Initial Version
+
+#include	"ControLeo2_ReflowEngine.h"
+
+#define DUTY_CYCLE_STEPS    100
+#define PATTERN_STEPS       8
+
+
+/*******************************************************************************
+* Name: ControLeo2_ReflowEngine
+* Description:  Constructor.  The outputs are not touched until start() is called,
+*               because the engine is normally a global and is constructed before
+*               the Arduino core is initialized.  The sketch's setup() should turn
+*               the outputs off.
+*
+* Argument  	Description
+* =========  	===========
+* 1. modulation   	REFLOW_MODULATION_DUTY_CYCLE or REFLOW_MODULATION_PATTERN
+* 2. stepInterval	Milliseconds between modulation steps.  0 means one step
+*                   each time tick() is called
+*******************************************************************************/
+ControLeo2_ReflowEngine::ControLeo2_ReflowEngine(uint8_t modulation, uint16_t stepInterval)
+{
+	_modulation = modulation;
+	_stepInterval = stepInterval;
+	_table = NULL;
+	_loader = NULL;
+	_levelHook = NULL;
+	_numPhases = 0;
+	_phaseNumber = 0;
+	_isRunning = false;
+	_outputs = 0;
+}
+
+
+// Use a function to fill in each phase, instead of reading it from a table in flash
+void ControLeo2_ReflowEngine::setPhaseLoader(void (*loader)(uint8_t phase, struct ReflowEnginePhase *data))
+{
+	_loader = loader;
+}
+
+
+// Call a function before switching each output, which can change the output's level
+void ControLeo2_ReflowEngine::setOutputLevelHook(uint8_t (*hook)(uint8_t output, uint8_t level, double temperature))
+{
+	_levelHook = hook;
+}
+
+
+/*******************************************************************************
+* Name: start
+* Description:  Start running a reflow profile
+*
+* Argument  	Description
+* =========  	===========
+* 1. table   	The phases, in flash (PROGMEM).  NULL if a phase loader is used
+* 2. numPhases	The number of phases
+* 3. now        The current time (millis())
+* 4. firstPhase	The phase to start in
+*******************************************************************************/
+void ControLeo2_ReflowEngine::start(const struct ReflowEnginePhase *table, uint8_t numPhases, unsigned long now, uint8_t firstPhase)
+{
+	_table = table;
+	_numPhases = numPhases;
+	_phaseNumber = firstPhase;
+	// Don't rely on the outputs being set up and off.  The sketch may have used them
+	for (uint8_t i = 0; i < REFLOW_ENGINE_OUTPUTS; i++)
+		pinMode(REFLOW_ENGINE_FIRST_OUTPUT + i, OUTPUT);
+	_isRunning = false;
+	writeOutputs(0);
+	_isRunning = true;
+	// Patterns carry on from one phase to the next, so they are started here
+	memset(_step, 0, sizeof(_step));
+	_nextStepTime = now + _stepInterval;
+	loadPhase(now);
+}
+
+
+// Stop the reflow and turn all the outputs off
+void ControLeo2_ReflowEngine::stop()
+{
+	_isRunning = false;
+	writeOutputs(0);
+}
+
+
+/*******************************************************************************
+* Name: tick
+* Description:  Check if the phase should change, and switch the outputs
+*
+* Argument  	Description
+* =========  	===========
+* 1. temperature	The current temperature, in Celsius
+* 2. now            The current time (millis())
+*
+* Return	    Description
+* =========		===========
+* event         REFLOW_EVENT_xxx.  The outputs are not switched on the tick that
+*               the phase changes, so the sketch can act on the new phase first.
+*******************************************************************************/
+uint8_t ControLeo2_ReflowEngine::tick(double temperature, unsigned long now)
+{
+	uint8_t event = REFLOW_EVENT_NONE;
+	unsigned long elapsed = now - _phaseStartTime;
+	boolean exitReached;
+
+	if (!_isRunning)
+		return REFLOW_EVENT_NONE;
+
+	if (_phase.flags & REFLOW_PHASE_TIMED) {
+		if (elapsed > _phase.maxDuration * 1000UL)
+			return nextPhase(now)? REFLOW_EVENT_NEXT_PHASE : REFLOW_EVENT_DONE;
+	}
+	else {
+		if (_phase.flags & REFLOW_PHASE_FALLING)
+			exitReached = temperature <= _phase.exitTemperature;
+		else
+			exitReached = temperature >= _phase.exitTemperature;
+
+		if (exitReached) {
+			// Let the sketch decide what to do if the phase was too short
+			if (elapsed < _phase.minDuration * 1000UL)
+				event = REFLOW_EVENT_TOO_FAST;
+			else
+				return nextPhase(now)? REFLOW_EVENT_NEXT_PHASE : REFLOW_EVENT_DONE;
+		}
+		else if (_phase.maxDuration && elapsed > _phase.maxDuration * 1000UL)
+			event = REFLOW_EVENT_TOO_SLOW;
+	}
+
+	updateOutputs(temperature, now);
+	return event;
+}
+
+
+// Move to the next phase.  Returns false (and stops) if this was the last phase
+boolean ControLeo2_ReflowEngine::nextPhase(unsigned long now)
+{
+	if (++_phaseNumber >= _numPhases) {
+		stop();
+		return false;
+	}
+	loadPhase(now);
+	return true;
+}
+
+
+// Allow more time in the current phase
+void ControLeo2_ReflowEngine::extendPhase(uint16_t seconds)
+{
+	_phase.maxDuration += seconds;
+}
+
+
+// Change the level of an output, for the rest of the current phase
+void ControLeo2_ReflowEngine::setOutputLevel(uint8_t output, uint8_t level)
+{
+	if (output < REFLOW_ENGINE_OUTPUTS)
+		_phase.level[output] = level;
+}
+
+
+// Start timing the current phase again
+void ControLeo2_ReflowEngine::restartPhaseTimer(unsigned long now)
+{
+	_phaseStartTime = now;
+}
+
+
+// Copy the current phase into RAM
+void ControLeo2_ReflowEngine::loadPhase(unsigned long now)
+{
+	if (_loader)
+		_loader(_phaseNumber, &_phase);
+	else
+		memcpy_P(&_phase, &_table[_phaseNumber], sizeof(_phase));
+	_phaseStartTime = now;
+
+	// Stagger the duty cycles to avoid abrupt changes in current draw.  The next output
+	// turns on when this one turns off.  For example, with two outputs at 20% the first
+	// starts at step 0 and the second at step 80, so the second turns on at step 100 (0)
+	// just as the first turns off at step 20
+	if (_modulation == REFLOW_MODULATION_DUTY_CYCLE) {
+		uint8_t start = 0;
+		for (uint8_t i = 0; i < REFLOW_ENGINE_OUTPUTS; i++) {
+			_step[i] = start;
+			start = (DUTY_CYCLE_STEPS + start - min(_phase.level[i], DUTY_CYCLE_STEPS)) % DUTY_CYCLE_STEPS;
+		}
+	}
+}
+
+
+// Work out which outputs should be on
+void ControLeo2_ReflowEngine::updateOutputs(double temperature, unsigned long now)
+{
+	uint8_t outputs = 0;
+
+	// Move on to the next step if it is time
+	if (_stepInterval && (long) (now - _nextStepTime) >= 0) {
+		_nextStepTime += _stepInterval;
+		advanceSteps();
+	}
+
+	for (uint8_t i = 0; i < REFLOW_ENGINE_OUTPUTS; i++) {
+		uint8_t level = _phase.level[i];
+		if (_levelHook)
+			level = _levelHook(i, level, temperature);
+
+		if (_modulation == REFLOW_MODULATION_DUTY_CYCLE) {
+			if (_step[i] < level)
+				outputs |= 1 << i;
+		}
+		else if (level & (0x80 >> _step[i]))
+			outputs |= 1 << i;
+	}
+	writeOutputs(outputs);
+
+	// One step per tick
+	if (!_stepInterval)
+		advanceSteps();
+}
+
+
+void ControLeo2_ReflowEngine::advanceSteps()
+{
+	uint8_t steps = (_modulation == REFLOW_MODULATION_DUTY_CYCLE)? DUTY_CYCLE_STEPS : PATTERN_STEPS;
+	for (uint8_t i = 0; i < REFLOW_ENGINE_OUTPUTS; i++)
+		if (++_step[i] >= steps)
+			_step[i] = 0;
+}
+
+
+// Switch the outputs.  Only the outputs that change are written
+void ControLeo2_ReflowEngine::writeOutputs(uint8_t outputs)
+{
+	for (uint8_t i = 0; i < REFLOW_ENGINE_OUTPUTS; i++) {
+		uint8_t mask = 1 << i;
+		if (!_isRunning || ((outputs ^ _outputs) & mask))
+			digitalWrite(REFLOW_ENGINE_FIRST_OUTPUT + i, (outputs & mask)? HIGH : LOW);
+	}
+	_outputs = outputs;
+}
@@ -0,0 +1,88 @@
+// Written by agent
+// Based on the reflow code in the ReflowWizard sketch by Peter Easton and the ReflowOven2
+// sketch by Keith Rome
+// Released under WTFPL license
+//
+// Change History:
+// 18 October 2026       Initial Version
+
+#ifndef CONTROLEO2_REFLOWENGINE_H
+#define CONTROLEO2_REFLOWENGINE_H
+
+#include "Arduino.h"
+
+// The outputs are D4 to D7
+#define REFLOW_ENGINE_FIRST_OUTPUT  4
+#define REFLOW_ENGINE_OUTPUTS       4
+
+// Phase flags
+#define REFLOW_PHASE_FALLING        0x01    // The phase ends when the temperature falls to exitTemperature (instead of rising to it)
+#define REFLOW_PHASE_TIMED          0x02    // The phase ends after maxDuration, regardless of temperature
+#define REFLOW_PHASE_ALARM          0x04    // Not used by the engine.  Front-ends can use it to sound an alarm when the phase ends
+
+// How the output levels are turned into on/off switching
+#define REFLOW_MODULATION_DUTY_CYCLE    0   // Level is a duty cycle (0-100) over 100 steps.  Outputs are staggered to spread the current draw
+#define REFLOW_MODULATION_PATTERN       1   // Level is an 8-bit on/off pattern, most significant bit first, one bit per step
+
+// Events returned by tick()
+#define REFLOW_EVENT_NONE           0
+#define REFLOW_EVENT_NEXT_PHASE     1       // The exit temperature was reached (or a timed phase ended).  Now in the next phase
+#define REFLOW_EVENT_TOO_FAST       2       // The exit temperature was reached before minDuration.  Call nextPhase() to move on, or do nothing to wait
+#define REFLOW_EVENT_TOO_SLOW       3       // The phase has taken longer than maxDuration.  Call nextPhase(), extendPhase() or stop()
+#define REFLOW_EVENT_DONE           4       // The last phase has ended, and all outputs are off
+
+// One phase of a reflow profile.  Tables of these are normally stored in flash (PROGMEM)
+struct ReflowEnginePhase {
+	int16_t		exitTemperature;            // Celsius
+	uint8_t		flags;                      // REFLOW_PHASE_xxx
+	uint16_t	minDuration;                // Seconds.  0 = no minimum
+	uint16_t	maxDuration;                // Seconds.  0 = no maximum
+	uint8_t		level[REFLOW_ENGINE_OUTPUTS];   // Output level for D4 to D7 (see REFLOW_MODULATION_xxx)
+};
+
+
+class ControLeo2_ReflowEngine
+{
+public:
+    ControLeo2_ReflowEngine(uint8_t modulation, uint16_t stepInterval);
+
+    // Hooks
+    void    setPhaseLoader(void (*loader)(uint8_t phase, struct ReflowEnginePhase *data));
+    void    setOutputLevelHook(uint8_t (*hook)(uint8_t output, uint8_t level, double temperature));
+
+    void    start(const struct ReflowEnginePhase *table, uint8_t numPhases, unsigned long now, uint8_t firstPhase = 0);
+    void    stop();
+    uint8_t tick(double temperature, unsigned long now);
+
+    // Used to respond to the events returned by tick()
+    boolean nextPhase(unsigned long now);
+    void    extendPhase(uint16_t seconds);
+    void    setOutputLevel(uint8_t output, uint8_t level);
+    void    restartPhaseTimer(unsigned long now);
+
+    boolean isRunning()                 { return _isRunning; }
+    uint8_t phase()                     { return _phaseNumber; }
+    unsigned long phaseStartTime()      { return _phaseStartTime; }
+    const struct ReflowEnginePhase *currentPhase()  { return &_phase; }
+
+private:
+    void    loadPhase(unsigned long now);
+    void    updateOutputs(double temperature, unsigned long now);
+    void    advanceSteps();
+    void    writeOutputs(uint8_t outputs);
+
+    const struct ReflowEnginePhase *_table;   // In flash (PROGMEM)
+    void    (*_loader)(uint8_t phase, struct ReflowEnginePhase *data);
+    uint8_t (*_levelHook)(uint8_t output, uint8_t level, double temperature);
+    struct ReflowEnginePhase _phase;    // Copy of the current phase
+    uint8_t _modulation;
+    uint16_t _stepInterval;             // Milliseconds per modulation step.  0 = one step per tick()
+    unsigned long _nextStepTime;
+    uint8_t _step[REFLOW_ENGINE_OUTPUTS];   // Position of each output in its duty cycle or pattern
+    uint8_t _outputs;                   // Bit mask of outputs that are on
+    uint8_t _numPhases;
+    uint8_t _phaseNumber;
+    unsigned long _phaseStartTime;
+    boolean _isRunning;
+};
+#endif  // CONTROLEO2_REFLOWENGINE_H
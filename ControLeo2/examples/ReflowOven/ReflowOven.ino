@@ -55,6 +55,7 @@
 * 1.00      Initial public release.
 * 1.1       Minor bug fixes
 * 1.2       Modified to work on ControLeo2 (21 October 2014)
+* 1.3       Use the reflow engine in the ControLeo2 library (18 October 2026)
 *******************************************************************************/
 
 
@@ -80,32 +81,31 @@ typedef enum
 #define SENSOR_SAMPLING_TIME 1000  // Frequency of reading temperature, in milliseconds
 #define ROOM_TEMP            50    // Temperature above which reflow process cannot be started
 #define TEMPERATURE_POINTS   5     // Number of phases in reflow process
-#define NO_OF_ELEMENTS       3     // NUmber of heating elements in the reflow oven
 
-// This array defines the temperature transition points during the relow process
-int tempPoints[2][TEMPERATURE_POINTS] = {
-      {50, 150, 200, 230, 235},  // Lead-free
-      {50, 130, 170, 185, 190},  // Leaded
-    };
-    
-// Each element of this array is a 8-second window for an element.  For example, if the value is 0b11001111 then
+// The reflow profiles.  Each phase ends when the temperature rises above its exit temperature.
+// The element levels are 8-second windows.  For example, if the value is 0b11001111 then
 // the element will be on for 2 seconds, off for 2 seconds then on for 4 seconds.  This pattern will keep 
-// repeating itself until the temperature rises through the temperate transition point given in tempPoints.  This
+// repeating itself until the temperature rises through the exit temperature.  This
 // gives fine control over each element and has the following benefits:
 // 1. Prevents individual elements from getting too hot, perhaps burning insulation.
 // 2. Ensures heat comes from the right part of the oven at the right time
 // 3. Helps overall current draw by being able to turn off some elements while turning others on
 // ==================== YOU SHOULD TUNE THESE VALUES TO YOUR REFLOW OVEN!!! ====================
-int elementCycle[2][NO_OF_ELEMENTS][TEMPERATURE_POINTS] = {
+const ReflowEnginePhase reflowProfiles[2][TEMPERATURE_POINTS] PROGMEM = {
       {    // Lead-free
-        {0b11011101, 0b11001101, 0b00110011, 0b11111101, 0b11111100},  // Upper element
-        {0b10111111, 0b10111110, 0b11101110, 0b11101111, 0b11100111},  // Lower element
-        {0b11101110, 0b01010011, 0b00010001, 0b10111010, 0b00011000},  // Boost Element
+        // Exit temp, flags, min/max duration, {Upper element (D4), Lower element (D5), Boost element (D6), unused}
+        {50,  0, 0, 0, {0b11011101, 0b10111111, 0b11101110, 0}},
+        {150, 0, 0, 0, {0b11001101, 0b10111110, 0b01010011, 0}},
+        {200, 0, 0, 0, {0b00110011, 0b11101110, 0b00010001, 0}},
+        {230, 0, 0, 0, {0b11111101, 0b11101111, 0b10111010, 0}},
+        {235, 0, 0, 0, {0b11111100, 0b11100111, 0b00011000, 0}},
       },
       {    // Leaded
-        {0b11011101, 0b11001101, 0b01000100, 0b11111110, 0b00010001},  // Upper element
-        {0b11111111, 0b11111110, 0b10101011, 0b11111111, 0b01000100},  // Lower element
-        {0b11101111, 0b01110011, 0b00010000, 0b11101101, 0b00000000},  // Boost Element
+        {50,  0, 0, 0, {0b11011101, 0b11111111, 0b11101111, 0}},
+        {130, 0, 0, 0, {0b11001101, 0b11111110, 0b01110011, 0}},
+        {170, 0, 0, 0, {0b01000100, 0b10101011, 0b00010000, 0}},
+        {185, 0, 0, 0, {0b11111110, 0b11111111, 0b11101101, 0}},
+        {190, 0, 0, 0, {0b00010001, 0b01000100, 0b00000000, 0}},
       }
     };
     
@@ -113,10 +113,6 @@ const char* reflowPhases[TEMPERATURE_POINTS] = {"Pre-heat", "Pre-heat", "Soak",
 
 // Default reflow mode is lead-free solder
 reflowType_t reflowType = REFLOW_TYPE_LEAD_FREE;
-int reflowPhase;
-
-// Pin assignments
-int elementPins[NO_OF_ELEMENTS] = {4, 5, 6};
 
 unsigned long nextCheck = 0;
 unsigned long nextRead = 0;
@@ -128,6 +124,8 @@ reflowStatus_t reflowStatus = REFLOW_STATUS_OFF;
 
 ControLeo2_LiquidCrystal lcd;
 ControLeo2_MAX31855 thermocouple;
+// Step through the element patterns once per second
+ControLeo2_ReflowEngine reflowEngine(REFLOW_MODULATION_PATTERN, 1000);
 
 
 void setup() {
@@ -153,7 +151,7 @@ void setup() {
   lcd.setCursor(0, 0);
   lcd.print("ControLeo2");
   lcd.setCursor(0, 1);
-  lcd.print("Reflow Oven 1.2");
+  lcd.print("Reflow Oven 1.3");
   delay(3000);
   lcd.clear();
 }
@@ -164,7 +162,6 @@ void loop()
   unsigned long timeNow = millis();
   static double currentTemperature;
   boolean updateThings = false;
-  static int reflowToggleCounter;
 
   // Time to read thermocouple?
   if (timeNow > nextRead)
@@ -206,17 +203,8 @@ void loop()
       return;
     }
       
-    // Should elements be turned on or off?
-    if (!updateThings)
-      return;
-      
-    // Determine which reflow state we're in
-    reflowPhase = 0;
-    while (reflowPhase < TEMPERATURE_POINTS && currentTemperature > tempPoints[reflowType][reflowPhase])
-      reflowPhase++;
-      
-    // Is the reflow done?
-    if (reflowPhase == TEMPERATURE_POINTS) {
+    // Let the reflow engine move through the phases and turn the elements on or off
+    if (reflowEngine.tick(currentTemperature, timeNow) == REFLOW_EVENT_DONE) {
       stopReflow();
       
       // Turn on buzzer to indicate completion
@@ -225,20 +213,6 @@ void loop()
       buzzerPeriod = timeNow + 1000;
       return;
     }
-    
-    // The reflow is underway.  Turn the elements on or off as necessary
-    for (int i = 0; i < NO_OF_ELEMENTS; i++) {
-      if (elementCycle[reflowType][i][reflowPhase] & reflowToggleCounter)
-        digitalWrite(elementPins[i], HIGH);    // On
-      else
-        digitalWrite(elementPins[i], LOW);     // Off
-    }
-    
-    // Advance the reflow toggle counter
-    if (reflowToggleCounter == 1)
-      reflowToggleCounter = 0x80;
-    else 
-      reflowToggleCounter = reflowToggleCounter >> 1;
   }
   else
   {
@@ -258,8 +232,7 @@ void loop()
       if (buttonPressed == CONTROLEO_BUTTON_BOTTOM) {
         // Start the reflow
         reflowStatus = REFLOW_STATUS_ON;
-        reflowToggleCounter = 0x80;
-        reflowPhase = 0;
+        reflowEngine.start(reflowProfiles[reflowType], TEMPERATURE_POINTS, timeNow);
         updateThings = true;
       }
     }
@@ -287,7 +260,7 @@ void loop()
     }
     else {
       // Display the reflow status
-      displayMessage(reflowPhases[reflowPhase], currentTemperature);
+      displayMessage(reflowPhases[reflowEngine.phase()], currentTemperature);
     }
   }
   
@@ -363,8 +336,7 @@ void displayMessage(const char* msg, double temperature)
 void stopReflow()
 {
   // Turn all elements off
-  for (int i = 0; i < NO_OF_ELEMENTS; i++)
-    digitalWrite(elementPins[i], LOW);
+  reflowEngine.stop();
         
   // Turn the reflow off
   reflowStatus = REFLOW_STATUS_OFF;
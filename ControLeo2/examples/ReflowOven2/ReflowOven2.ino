@@ -95,6 +95,7 @@
 * ========  ===========
 * 1.00      Initial public release.
 * 2.00      Public release.
+* 2.10      Use the reflow engine in the ControLeo2 library (18 October 2026)
 *******************************************************************************/
 
 // ***** INCLUDES *****
@@ -108,7 +109,6 @@
 #define CYCLE_INTERVAL  1000  // how frequently the oven cycles through the current phase's heating pattern (ms per bit)
 #define MAX_START_TEMP    50  // maximum temperature where a new reflow session will be allowed to start
 #define NUM_PHASES         4  // number of phases in a profile (always assume a final "cooling" phase)
-#define NUM_HEATERS        3  // number of heaters installed
 #define DEFAULT_PROFILE    0  // default temperature profile at startup (overridden by EEPROM)
 #define BUZZER_DURATION  250  // how long to play buzzer sounds
 #define ADDR_CURR_PROFILE  0  // address in EEPROM for storing the current profile ID
@@ -123,70 +123,67 @@ const char* PRODUCT_ID = "Reflow Oven v2";
 // ***** HARDWARE INTERFACES *****
 struct Hardware {
   unsigned long DisableBuzzerAt;
-  int HeaterPins[NUM_HEATERS];     // Pin assignments
   ControLeo2_LiquidCrystal LCD;     // Specify LCD interface
   ControLeo2_MAX31855 Thermocouple; // Specify MAX31855 thermocouple interface
 };
-Hardware hardware = { 0, {
-    4, // upper heater pin
-    5, // lower heater pin
-    6  // booster heater pin
-  },
+Hardware hardware = { 0,
   ControLeo2_LiquidCrystal(),
   ControLeo2_MAX31855() };
 
+// The reflow engine switches the heaters (upper on D4, lower on D5 and booster on D6)
+ControLeo2_ReflowEngine reflowEngine(REFLOW_MODULATION_PATTERN, CYCLE_INTERVAL);
+
 // ***** PROFILES *****
 // Each element of this array is a 8-second window for an element.  For example, if the value is 0b11001111 then
 // the element will be on for 2 seconds, off for 2 seconds then on for 4 seconds.  This pattern will keep 
-// repeating itself until the temperature rises through the temperate transition point given in tempPoints.  This
+// repeating itself until the temperature crosses the phase's exit temperature.  This
 // gives fine control over each element and has the following benefits:
 // 1. Prevents individual elements from getting too hot, perhaps burning insulation.
 // 2. Ensures heat comes from the right part of the oven at the right time
 // 3. Helps overall current draw by being able to turn off some elements while turning others on
 // ==================== YOU SHOULD TUNE THESE VALUES TO YOUR REFLOW OVEN!!! ====================
-enum CrossingDirection {
-  RISE,
-  FALL
-};
-struct ReflowPhase {
-  char* Name;
-  int ExitTemperatureC;
-  CrossingDirection RisingOrFalling;
-  int MinDurationS;
-  int MaxDurationS;
-  int TargetDurationS;
-  int HeaterPattern[NUM_HEATERS];
-  boolean AlarmOnExit;
-};
-ReflowPhase idlePhase    = { "Idle",                 0, RISE, 0, 0, 0, { 0b00000000, 0b00000000, 0b00000000 }, false };
-ReflowPhase coolingPhase = { "Cooling", MAX_START_TEMP, FALL, 0, 0, 0, { 0b00000000, 0b00000000, 0b00000000 }, false };
+#define RISE     0
+#define FALL     REFLOW_PHASE_FALLING
+#define ALARM    REFLOW_PHASE_ALARM   // alarm sounds when the phase ends
 
+// The profiles are kept in flash.  The first phase is always "idle" (the oven is off), so it isn't
+// included here.  The last phase of each profile is always "cooling"
 struct ReflowProfile {
-  char* Name;
-  ReflowPhase Phases[NUM_PHASES];
+  char Name[17];
+  uint8_t TargetDurationS[NUM_PHASES];          // shown in the serial log for fine-tuning
+  ReflowEnginePhase Phases[NUM_PHASES + 1];     // the profile's phases, followed by cooling
 };
-ReflowProfile profiles[] = {
+const ReflowProfile profiles[] PROGMEM = {
   {
     "Lead-free solder",
-    {  //   Zone      Exit(C)  Direction  Min(S)  Max(S)  Tgt(S)     Upper       Lower       Boost       Alarm
-      { "Pre-heat",     150,     RISE,       0,      0,     90, { 0b11001101, 0b10111110, 0b01010011 }, false },
-      { "Soak",         205,     RISE,      30,    120,     30, { 0b01000100, 0b10101011, 0b00010000 }, false },
-      { "Liquidus",     235,     RISE,      30,     90,     60, { 0b11011110, 0b10111111, 0b01101101 }, false },
-      { "Reflow",       225,     FALL,      30,     90,     60, { 0b00010001, 0b01000100, 0b00000000 }, true },
+    // Tgt(S) for each zone
+    {     90,         30,         60,         60 },
+    {  //   Exit(C)  Direction+Alarm  Min(S)  Max(S)     Upper       Lower       Boost
+      /* Pre-heat */ { 150,  RISE,         0,      0, { 0b11001101, 0b10111110, 0b01010011, 0 } },
+      /* Soak     */ { 205,  RISE,        30,    120, { 0b01000100, 0b10101011, 0b00010000, 0 } },
+      /* Liquidus */ { 235,  RISE,        30,     90, { 0b11011110, 0b10111111, 0b01101101, 0 } },
+      /* Reflow   */ { 225,  FALL | ALARM, 30,    90, { 0b00010001, 0b01000100, 0b00000000, 0 } },
+      /* Cooling  */ { MAX_START_TEMP, FALL, 0,    0, { 0b00000000, 0b00000000, 0b00000000, 0 } },
     }
   },
   {
     "Leaded solder",
-    {  //   Zone      Exit(C)  Direction  Min(S)  Max(S)  Tgt(S)     Upper       Lower       Boost       Alarm
-      { "Pre-heat",     145,     RISE,       0,      0,     90, { 0b11001101, 0b01110110, 0b01010011 }, false },
-      { "Soak",         180,     RISE,      30,    120,     30, { 0b01000100, 0b10101011, 0b00010001 }, false },
-      { "Liquidus",     210,     RISE,      30,     90,     60, { 0b10111110, 0b11110111, 0b00101000 }, true },
-      { "Reflow",       180,     FALL,      30,     90,     60, { 0b01000000, 0b00011000, 0b00000100 }, false },
+    // Tgt(S) for each zone
+    {     90,         30,         60,         60 },
+    {  //   Exit(C)  Direction+Alarm  Min(S)  Max(S)     Upper       Lower       Boost
+      /* Pre-heat */ { 145,  RISE,         0,      0, { 0b11001101, 0b01110110, 0b01010011, 0 } },
+      /* Soak     */ { 180,  RISE,        30,    120, { 0b01000100, 0b10101011, 0b00010001, 0 } },
+      /* Liquidus */ { 210,  RISE | ALARM, 30,    90, { 0b10111110, 0b11110111, 0b00101000, 0 } },
+      /* Reflow   */ { 180,  FALL,        30,     90, { 0b01000000, 0b00011000, 0b00000100, 0 } },
+      /* Cooling  */ { MAX_START_TEMP, FALL, 0,    0, { 0b00000000, 0b00000000, 0b00000000, 0 } },
     }
   },
 };
 #define NUM_PROFILES (sizeof(profiles)/sizeof(ReflowProfile)) //array size is computed from initialized data
 
+// The names of the phases, including idle and cooling
+const char phaseNames[NUM_PHASES + 2][9] PROGMEM = { "Idle", "Pre-heat", "Soak", "Liquidus", "Reflow", "Cooling" };
+
 // ***** STATE TRACKING *****
 struct OvenState {
   int SelectedProfile;
@@ -197,19 +194,15 @@ struct OvenState {
   unsigned long LastClocked;
   unsigned long NextClock;
   unsigned long NextSample;
-  unsigned long NextCycle;
-  int ActiveHeatCycle;
   int ActivePhase;
   unsigned long EnteredCurrentPhase;
   int SecInPhase;
   unsigned long ActiveSince;
-  ReflowPhase PhaseSchedule[NUM_PHASES + 2];
 };
 OvenState currentState = {
   -1, false, false, 0, 0,
-  0, CLOCK_INTERVAL, SAMPLE_INTERVAL, CYCLE_INTERVAL,
-  0, 0, 0, 0, 0,
-  { idlePhase, idlePhase, idlePhase, idlePhase, idlePhase, coolingPhase} };
+  0, CLOCK_INTERVAL, SAMPLE_INTERVAL,
+  0, 0, 0, 0 };
 
 
 void setup()
@@ -237,12 +230,6 @@ void setup()
   Serial.begin(9600);
   Serial.print(BRAND_ID); Serial.print(" "); Serial.print(PRODUCT_ID); Serial.println(" firmware startup");
 
-  // configure heater GPIO
-  for (int i = 0; i < NUM_HEATERS; i++) {
-    pinMode(hardware.HeaterPins[i], OUTPUT);
-    digitalWrite(hardware.HeaterPins[i], LOW);
-  }
-  
   int lastProfile = EEPROM.read(ADDR_CURR_PROFILE);
   if (lastProfile == 255) {
     lastProfile = DEFAULT_PROFILE;
@@ -267,7 +254,6 @@ void loop()
   if (currentState.LastClocked > now) {
     currentState.LastClocked = 0;
     currentState.NextClock = CLOCK_INTERVAL;
-    currentState.NextCycle = CYCLE_INTERVAL;
     currentState.NextSample = SAMPLE_INTERVAL;
     currentState.EnteredCurrentPhase = 0;
   }
@@ -278,19 +264,13 @@ void loop()
     currentState.NextSample = now + SAMPLE_INTERVAL;
   }
   
-  // should we check for phase transition this cycle?
+  // should we check for phase transition (and switch the heaters) this cycle?
   if (currentState.NextClock <= now) {
     CheckForPhaseTransition();
     currentState.LastClocked = now;
     currentState.NextClock = now + CLOCK_INTERVAL;
   }
   
-  // advance the heater pattern
-  if (currentState.NextCycle <= now) {
-    AdvanceHeatingCycle();
-    currentState.NextCycle = now + CYCLE_INTERVAL;
-  }
-  
   // always check for button press so there is no unnecessary lag
   // also, in the unlikely event that a phase transition and button press happen in the same
   // cycle, the button press will always get the last s
@@ -352,12 +332,16 @@ void WriteAt(int line, int column, int glyph)
 
 void DisplayProfile()
 {
-  PrintAt(0, 0, 16, false, profiles[currentState.SelectedProfile].Name);
+  char name[sizeof(profiles[0].Name)];
+  strcpy_P(name, profiles[currentState.SelectedProfile].Name);
+  PrintAt(0, 0, 16, false, name);
 }
 
 void DisplayPhase()
 {
-  PrintAt(0, 0, 11, false, currentState.PhaseSchedule[currentState.ActivePhase].Name);
+  char name[sizeof(phaseNames[0])];
+  strcpy_P(name, phaseNames[currentState.ActivePhase]);
+  PrintAt(0, 0, 11, false, name);
 }
 
 void DisplayElapsedInPhase(boolean forceUpdate)
@@ -366,7 +350,8 @@ void DisplayElapsedInPhase(boolean forceUpdate)
   if (forceUpdate || (secInPhase != currentState.SecInPhase)) {
     currentState.SecInPhase = secInPhase;
     char msg[6];
-    sprintf(msg, " %ds", secInPhase);
+    formatNumber(msg, secInPhase, 4);
+    strcat(msg, "s");
     PrintAt(0, 11, 5, true, msg);
   }
 }
@@ -380,12 +365,11 @@ void UpdateDisplayedTemperature()
   }
   
   // Print current temperature
-  char buffer[12];
-  dtostrf(currentState.TemperatureC, 3, 1, buffer);
+  char buffer[FORMAT_MAX_DIGITS + 3];
+  formatNumber(buffer, (long) (currentState.TemperatureC * 10 + (currentState.TemperatureC < 0? -0.5 : 0.5)), 0, 1);
   int sz = strlen(buffer);
-  char msg[12];
-  sprintf(msg, "%s %s", buffer, "C");
-  PrintAt(1, 0, 12, false, msg);
+  strcat(buffer, " C");
+  PrintAt(1, 0, 12, false, buffer);
   
   // draw the special glyph for degree symbol
   WriteAt(1, sz, 0);
@@ -512,80 +496,49 @@ int GetRisingEdgeOfButtonPress()
   return buttonEvent;
 }
 
-void AdvanceHeatingCycle()
-{
-  int mask = 0b10000000 >> currentState.ActiveHeatCycle;
-  
-  if (currentState.IsActive) {
-    currentState.ActiveHeatCycle++;
-    if (currentState.ActiveHeatCycle > 7) {
-      currentState.ActiveHeatCycle = 0;
-    }
-  } else {
-    mask = 0b00000000; // disable all heaters
-  }
-  
-  // toggle heater GPIO pins
-  ReflowPhase currentPhase = currentState.PhaseSchedule[currentState.ActivePhase];
-  for (int heaterIx = 0; heaterIx < NUM_HEATERS; heaterIx++) {
-    if (currentPhase.HeaterPattern[heaterIx] & mask) {
-      digitalWrite(hardware.HeaterPins[heaterIx], HIGH);
-    } else {
-      digitalWrite(hardware.HeaterPins[heaterIx], LOW);
-    }
-  }
-}
-
 void CheckForPhaseTransition()
 {
   if (!currentState.IsActive) return;
   
   DisplayElapsedInPhase(false);
   
-  // can't leave idle without explicit start
-  if (currentState.ActivePhase == 0) return;
-  
-  ReflowPhase currentPhase = currentState.PhaseSchedule[currentState.ActivePhase];
-  int timeInPhase = (millis() - currentState.EnteredCurrentPhase) / 1000;
-  CrossingDirection dir = currentPhase.RisingOrFalling;
-    
-  // check for phase change due to temperature rise
-  if (dir == RISE) {
-    if (currentPhase.ExitTemperatureC <= currentState.TemperatureC) {
-      if (currentPhase.MinDurationS == 0) {
-        MoveToNextPhase("Exit Temperature Reached", timeInPhase);
-      } else {
-        // but only allow phase change if any minimum time spent in phase has been met
-        if (timeInPhase > currentPhase.MinDurationS) {
-          MoveToNextPhase("Duration/Temperature Reached", timeInPhase);
-        }
-      }
-    }
-  }
-    
-  // check for phase change due to temperature fall
-  if (dir == FALL) {
-    if (currentPhase.ExitTemperatureC >= currentState.TemperatureC) {
-      if (currentPhase.MinDurationS == 0) {
-        MoveToNextPhase("Exit Temperature Reached", timeInPhase);
-      } else {
-        // but only allow phase change if any minimum time spent in phase has been met
-        if (timeInPhase > currentPhase.MinDurationS) {
-          MoveToNextPhase("Duration/Temperature Reached", timeInPhase);
-        }
+  // the reflow engine switches the heaters and decides when to move to the next phase.
+  // Remember what the current phase needs before it does
+  unsigned long now = millis();
+  uint8_t flags = reflowEngine.currentPhase()->flags;
+  uint16_t minDuration = reflowEngine.currentPhase()->minDuration;
+  int timeInPhase = (now - currentState.EnteredCurrentPhase) / 1000;
+  
+  switch (reflowEngine.tick(currentState.TemperatureC, now)) {
+    case REFLOW_EVENT_NEXT_PHASE:
+      // exit temperature reached, and any minimum time spent in phase has been met
+      PrintTransitionReason(minDuration? "Duration/Temperature Reached" : "Exit Temperature Reached", timeInPhase);
+      break;
+    case REFLOW_EVENT_TOO_SLOW:
+      // phase change due to timer overrun
+      PrintTransitionReason("Max Duration Exceeded", timeInPhase);
+      if (!reflowEngine.nextPhase(now)) {
+        End(false);
+        return;
       }
-    }
-  }
-  
-  // check for phase change due to timer overrun
-  if (currentPhase.MaxDurationS > 0) {
-    if (timeInPhase >= currentPhase.MaxDurationS) {
-      MoveToNextPhase("Max Duration Exceeded", timeInPhase);
-    }
+      break;
+    case REFLOW_EVENT_DONE:
+      // transition beyond cooling phase
+      PrintTransitionReason("Exit Temperature Reached", timeInPhase);
+      End(false);
+      return;
+    default:
+      // still in the same phase.  Reaching the exit temperature too soon just means waiting
+      return;
+  }
+  
+  TransitionToPhase(reflowEngine.phase() + 1);
+  if (flags & ALARM) {
+    EnableBuzzer(ON);
   }
 }
 
-void MoveToNextPhase(char* reason, int timeInPhase)
+void PrintTransitionReason(const char* reason, int timeInPhase)
 {
   Serial.print("**");
   Serial.print(reason);
@@ -594,15 +547,17 @@ void MoveToNextPhase(char* reason, int timeInPhase)
   Serial.print("s, Temperature: ");
   Serial.print(currentState.TemperatureC);
   Serial.println("C");
-  TransitionToPhase(currentState.ActivePhase + 1);
 }
 
 void Start()
 {
-  Serial.print("Starting Profile: "); Serial.println(profiles[currentState.SelectedProfile].Name);
+  char name[sizeof(profiles[0].Name)];
+  strcpy_P(name, profiles[currentState.SelectedProfile].Name);
+  Serial.print("Starting Profile: "); Serial.println(name);
   currentState.PeakTemperatureC = 0; // reset
   currentState.ActiveSince = millis(); // reset
   currentState.IsActive = true;
+  reflowEngine.start(profiles[currentState.SelectedProfile].Phases, NUM_PHASES + 1, millis());
   TransitionToPhase(1);
 }
 
@@ -625,8 +580,12 @@ void ResetState()
   CaptureTemperatureSample();
   if (currentState.TemperatureC > MAX_START_TEMP) {
     currentState.IsActive = true;
+    // start in the cooling phase
+    reflowEngine.start(profiles[currentState.SelectedProfile].Phases, NUM_PHASES + 1, millis(), NUM_PHASES);
     TransitionToPhase(NUM_PHASES + 1);
   } else {
+    // turn the heaters off
+    reflowEngine.stop();
     TransitionToPhase(0);
     currentState.IsActive = false;
     // Return to profile display
@@ -634,61 +593,47 @@ void ResetState()
   }
 }
 
+// Show that the phase has changed.  The idle phase has no exit temperature or durations
 void TransitionToPhase(int phase)
 {
   if (phase == currentState.ActivePhase) return;
   
-  if (phase > NUM_PHASES + 1) {
-    // transition beyond cooling phase
-    End(false);
-    return;
-  }
-
   int timeInLastPhase = (millis() - currentState.EnteredCurrentPhase) / 1000;
-  ReflowPhase oldPhase = currentState.PhaseSchedule[currentState.ActivePhase];
-  ReflowPhase newPhase = currentState.PhaseSchedule[phase];
+  const ReflowEnginePhase *newPhase = reflowEngine.currentPhase();
+  boolean isIdle = (phase == 0);
   
-  Serial.print("Leaving Phase: "); Serial.print(oldPhase.Name); 
+  Serial.print("Leaving Phase: "); Serial.print((const __FlashStringHelper *) phaseNames[currentState.ActivePhase]); 
   Serial.print(" ("); Serial.print(currentState.ActivePhase); 
   Serial.print("), Elapsed: "); Serial.print(timeInLastPhase); Serial.println("s");
   
-  Serial.print("Entering Phase: "); Serial.print(newPhase.Name); 
+  Serial.print("Entering Phase: "); Serial.print((const __FlashStringHelper *) phaseNames[phase]); 
   Serial.print(" ("); Serial.print(phase); 
-  Serial.print("), Exit Temp:"); Serial.print(newPhase.ExitTemperatureC); Serial.print("C");
-  if (newPhase.RisingOrFalling == FALL) Serial.print(" (falling)");
-  Serial.print(", Min Time: "); Serial.print(newPhase.MinDurationS); 
-  Serial.print("s, Max: "); Serial.print(newPhase.MaxDurationS); 
-  Serial.print("s, Ideal: "); Serial.print(newPhase.TargetDurationS); Serial.print("s");
-  if (newPhase.AlarmOnExit) Serial.print(", alarm sounds on exit");
+  Serial.print("), Exit Temp:"); Serial.print(isIdle? 0 : newPhase->exitTemperature); Serial.print("C");
+  if (!isIdle && (newPhase->flags & FALL)) Serial.print(" (falling)");
+  Serial.print(", Min Time: "); Serial.print(isIdle? 0 : newPhase->minDuration); 
+  Serial.print("s, Max: "); Serial.print(isIdle? 0 : newPhase->maxDuration); 
+  Serial.print("s, Ideal: ");
+  Serial.print(phase >= 1 && phase <= NUM_PHASES? pgm_read_byte(&profiles[currentState.SelectedProfile].TargetDurationS[phase - 1]) : 0);
+  Serial.print("s");
+  if (!isIdle && (newPhase->flags & ALARM)) Serial.print(", alarm sounds on exit");
   Serial.println();
 
   currentState.ActivePhase = phase;
   currentState.EnteredCurrentPhase = millis();
   DisplayPhase();
   DisplayElapsedInPhase(true);
-  
-  if (oldPhase.AlarmOnExit) {
-    EnableBuzzer(ON);
-  }
 }
 
 void AdvanceProfile(boolean silently)
 {
   Serial.println("Advancing to next profile");
   
-  // select the next profile
+  // select the next profile.  The reflow engine reads its phases from flash when it starts
   currentState.SelectedProfile++;
   if (currentState.SelectedProfile >= NUM_PROFILES) {
     currentState.SelectedProfile = 0;
   }
   
-  // copy the phases to phase schedule
-  ReflowProfile newProfile = profiles[currentState.SelectedProfile];
-  for (int phaseIx = 0; phaseIx < NUM_PHASES; phaseIx++) {
-    // first phase in schedule is always the "idle" phase, and last is always "cooling"
-    currentState.PhaseSchedule[phaseIx +1] = newProfile.Phases[phaseIx];
-  }
-  
   if (!silently) {
     // update the UI
     DisplayProfile();
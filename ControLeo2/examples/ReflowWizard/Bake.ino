@@ -2,8 +2,6 @@
 // Called from the main loop 20 times per second
 // This where the bake logic is controlled
 
-extern char debugBuffer[];
-
 #define MILLIS_TO_SECONDS    ((long) 1000)
 
 // Return false to exit this mode
@@ -16,6 +14,8 @@ boolean Bake() {
   static int bakeDutyCycle, bakeIntegral, counter, coolingDuration;
   static boolean isHeating;
   static long lastOverTempTime = 0;
+  static int learnedDutyCycle;
+  static uint16_t secondsSinceDutyCycleChange;
   
   double currentTemperature;
   int i;
@@ -30,19 +30,19 @@ boolean Bake() {
   // Read the temperature
   currentTemperature = getCurrentTemperature();
   if (THERMOCOUPLE_FAULT(currentTemperature)) {
-    lcdPrintLine(0, "Thermocouple err");
+    lcdPrintLine_P(0, PSTR("Thermocouple err"));
     Serial.print(F("Thermocouple Error: "));
     switch ((int) currentTemperature) {
       case FAULT_OPEN:
-        lcdPrintLine(1, "Fault open");
+        lcdPrintLine_P(1, PSTR("Fault open"));
         Serial.println(F("Fault open"));
         break;
       case FAULT_SHORT_GND:
-        lcdPrintLine(1, "Short to GND");
+        lcdPrintLine_P(1, PSTR("Short to GND"));
         Serial.println(F("Short to ground"));
         break;
       case FAULT_SHORT_VCC:
-        lcdPrintLine(1, "Short to VCC");
+        lcdPrintLine_P(1, PSTR("Short to VCC"));
         break;
     }
     
@@ -55,8 +55,8 @@ boolean Bake() {
   // Abort the bake if a button is pressed
   if (getButton() != CONTROLEO_BUTTON_NONE) {
     bakePhase = BAKING_PHASE_ABORT;
-    lcdPrintLine(0, "Aborting bake");
-    lcdPrintLine(1, "Button pressed");
+    lcdPrintLine_P(0, PSTR("Aborting bake"));
+    lcdPrintLine_P(1, PSTR("Button pressed"));
     Serial.println(F("Button pressed.  Aborting bake ..."));
     delay(2000);
   }
@@ -81,8 +81,8 @@ boolean Bake() {
         if (isHeatingElement(outputType[i]))
           break;
       if (i == 4) {
-        lcdPrintLine(0, "Please configure");
-        lcdPrintLine(1, " outputs first! ");
+        lcdPrintLine_P(0, PSTR("Please configure"));
+        lcdPrintLine_P(1, PSTR(" outputs first! "));
         Serial.println(F("Outputs must be configured before baking"));
         
         // Abort the baking
@@ -99,11 +99,19 @@ boolean Bake() {
       
       // Move to the next phase
       bakePhase = BAKING_PHASE_HEATUP;
-      lcdPrintLine(0, bakingPhaseDescription[bakePhase]);
-      lcdPrintLine(1, "");
+      lcdPrintLine_P(0, getDescription(bakingPhaseDescription, bakePhase));
+      lcdPrintLine_P(1, PSTR(""));
 
       // Start with a duty cycle proportional to the desired temperature
       bakeDutyCycle = map(bakeTemperature, 0, 250, 0, 100);
+
+      // Has the steady-state duty cycle for this temperature been learned on a previous bake?
+      learnedDutyCycle = getLearnedBakeDutyCycle(bakeTemperature);
+      if (learnedDutyCycle) {
+        Serial.print(F("Learned bake duty cycle = "));
+        Serial.println(learnedDutyCycle);
+      }
+      secondsSinceDutyCycleChange = 0;
       
       isHeating = true;
       bakeIntegral = 0;
@@ -126,9 +134,10 @@ boolean Bake() {
       // Is the oven close to the desired temperature?
       if (bakeTemperature - currentTemperature < 15.0) {
         bakePhase = BAKING_PHASE_BAKE;
-        lcdPrintLine(0, bakingPhaseDescription[bakePhase]);
-        // Reduce the duty cycle for the last 10 degrees
-        bakeDutyCycle = bakeDutyCycle / 3;
+        lcdPrintLine_P(0, getDescription(bakingPhaseDescription, bakePhase));
+        // Reduce the duty cycle for the last 10 degrees.  If the duty cycle for this
+        // temperature has been learned then start with that instead
+        bakeDutyCycle = learnedDutyCycle? learnedDutyCycle : bakeDutyCycle / 3;
         Serial.println(F("Move to bake phase"));
        }
        break;
@@ -145,6 +154,12 @@ boolean Bake() {
           break;
         }
 
+        // Save the duty cycle once it has settled, so the next bake at this temperature can start with it
+        if (++secondsSinceDutyCycleChange == BAKE_DUTY_CYCLE_SETTLE_TIME) {
+          setLearnedBakeDutyCycle(bakeTemperature, bakeDutyCycle);
+          Serial.println(F("Duty cycle has settled.  Saving it for future bakes"));
+        }
+
         // Is the oven too hot?
         if (currentTemperature > bakeTemperature) {
           if (isHeating) {
@@ -159,8 +174,10 @@ boolean Bake() {
             // (but not more than once every 30 seconds)
             if (millis() - lastOverTempTime > (30 * MILLIS_TO_SECONDS)) {
               lastOverTempTime = millis();
-              if (bakeDutyCycle > 0)
+              if (bakeDutyCycle > 0) {
                 bakeDutyCycle--;
+                secondsSinceDutyCycleChange = 0;
+              }
             }
 
             // Reset the bake integral, so it will be slow to increase the duty cycle again
@@ -182,8 +199,10 @@ boolean Bake() {
         if (bakeIntegral > 30) {
           bakeIntegral = 0;
           // Increase duty cycles
-          if (bakeDutyCycle < 100)
+          if (bakeDutyCycle < 100) {
             bakeDutyCycle++;
+            secondsSinceDutyCycleChange = 0;
+          }
             Serial.println(F("Under-temp. Increasing duty cycle"));
         }
       }
@@ -208,7 +227,7 @@ boolean Bake() {
       
       // Move to the next phase
       bakePhase = BAKING_PHASE_COOLING;
-      lcdPrintLine(0, bakingPhaseDescription[bakePhase]);
+      lcdPrintLine_P(0, getDescription(bakingPhaseDescription, bakePhase));
 
       // If a servo is attached, use it to open the door over 10 seconds
       setServoPosition(getSetting(SETTING_SERVO_OPEN_DEGREES), 10000);
@@ -283,13 +302,19 @@ boolean Bake() {
 
 // Display the current temperature to the LCD screen and print it to the serial port so it can be plotted
 void DisplayBakeTime(uint16_t duration, double temperature, int duty, int integral) {
+  char buffer[FORMAT_MAX_DIGITS + 1];
+
   // Display the temperature on the LCD screen
   displayTemperature(temperature);
 
   // Write the time and temperature to the serial port, for graphing or analysis on a PC
-  sprintf(debugBuffer, "%u, %i, %i, ", duration, duty, integral);
-  Serial.print(debugBuffer);
-  Serial.println(temperature);
+  Serial.print(duration);
+  Serial.print(F(", "));
+  Serial.print(duty);
+  Serial.print(F(", "));
+  Serial.print(integral);
+  Serial.print(F(", "));
+  Serial.println(formatTemperature(buffer, temperature, 0));
 
   displayDuration(10, duration);
 }
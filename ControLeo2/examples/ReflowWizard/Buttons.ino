@@ -0,0 +1,182 @@
+// Buttons
+// The buttons are captured by interrupts, so a press is never missed even if it is
+// shorter than one pass of the main loop.  Presses, releases, long presses and repeats
+// (while a button is held down) are put into a small queue, and read by getButton() or
+// getButtonEvent().
+//
+// - The top button is on D11 (PB7), which uses pin change interrupt PCINT7
+// - The bottom button is on D2 (PD1), which uses external interrupt INT1
+// - The first change of a button is acted on immediately.  Further changes within
+//   BUTTON_DEBOUNCE_TIME are contact bounce and are ignored.  If the bounce ends with the
+//   button in a different state, the Timer 1 interrupt picks it up 20ms later
+// - The Timer 1 interrupt (see Servo.ino) also generates the long press and repeat events
+//
+// The queue is written by interrupts and read by the main loop.  AVR interrupts don't
+// interrupt each other, and the head and tail are single bytes, so no locking is needed.
+
+#define BUTTON_TOP_INDEX      0
+#define BUTTON_BOTTOM_INDEX   1
+
+volatile struct buttonEvent buttonQueue[BUTTON_QUEUE_SIZE];
+volatile uint8_t buttonQueueHead;     // Written by the interrupts
+volatile uint8_t buttonQueueTail;     // Written by the main loop
+
+// The state of each button.  Only used by the interrupts
+boolean buttonIsDown[2];
+unsigned long buttonChangeTime[2];    // When the button was last pressed or released
+unsigned long buttonRepeatTime[2];    // When the next repeat is due
+uint16_t buttonRepeatInterval[2];     // Time between repeats.  This gets shorter as the button is held
+boolean buttonLongPressSent[2];
+
+
+// Start capturing button changes
+void initializeButtons() {
+  // The buttons are connected to ground when pressed, so they need pull-ups
+  pinMode(CONTROLEO_BUTTON_TOP_PIN, INPUT_PULLUP);
+  pinMode(CONTROLEO_BUTTON_BOTTOM_PIN, INPUT_PULLUP);
+
+  // Top button: pin change interrupt on PCINT7 only
+  PCMSK0 |= _BV(PCINT7);
+  PCICR |= _BV(PCIE0);
+
+  // Bottom button: external interrupt
+  attachInterrupt(digitalPinToInterrupt(CONTROLEO_BUTTON_BOTTOM_PIN), bottomButtonChanged, CHANGE);
+}
+
+
+// Top button pin change interrupt
+ISR(PCINT0_vect)
+{
+  buttonChanged(BUTTON_TOP_INDEX);
+}
+
+
+// Bottom button external interrupt
+void bottomButtonChanged() {
+  buttonChanged(BUTTON_BOTTOM_INDEX);
+}
+
+
+// Add an event to the queue.  Called from interrupts only
+// If the queue is full the event is dropped - the main loop hasn't been reading them anyway
+void queueButtonEvent(int index, uint8_t type, unsigned long now) {
+  uint8_t head = buttonQueueHead;
+  if (((head + 1) & (BUTTON_QUEUE_SIZE - 1)) == buttonQueueTail)
+    return;
+  buttonQueue[head].button = index == BUTTON_TOP_INDEX? CONTROLEO_BUTTON_TOP : CONTROLEO_BUTTON_BOTTOM;
+  buttonQueue[head].type = type;
+  buttonQueue[head].time = now;
+  // Only make the event visible to the main loop once it has been written
+  buttonQueueHead = (head + 1) & (BUTTON_QUEUE_SIZE - 1);
+}
+
+
+// Check if the button has been pressed or released.  Called from interrupts only
+void buttonChanged(int index) {
+  unsigned long now = millis();
+  boolean isDown = digitalRead(index == BUTTON_TOP_INDEX? CONTROLEO_BUTTON_TOP_PIN : CONTROLEO_BUTTON_BOTTOM_PIN) == LOW;
+
+  // Ignore contact bounce, and changes to the other pins on the same interrupt
+  if (isDown == buttonIsDown[index] || now - buttonChangeTime[index] < BUTTON_DEBOUNCE_TIME)
+    return;
+
+  buttonIsDown[index] = isDown;
+  buttonChangeTime[index] = now;
+  if (isDown) {
+    queueButtonEvent(index, BUTTON_EVENT_PRESS, now);
+    buttonRepeatTime[index] = now + BUTTON_LONG_PRESS_TIME;
+    buttonRepeatInterval[index] = BUTTON_REPEAT_START_INTERVAL;
+    buttonLongPressSent[index] = false;
+  }
+  else
+    queueButtonEvent(index, BUTTON_EVENT_RELEASE, now);
+}
+
+
+// Called from the Timer 1 interrupt every 20ms
+// Picks up changes that happened during contact bounce, and generates the long press
+// and repeat events for buttons that are held down
+void updateButtons() {
+  unsigned long now = millis();
+
+  for (int i=0; i<2; i++) {
+    buttonChanged(i);
+    if (!buttonIsDown[i] || (long) (now - buttonRepeatTime[i]) < 0)
+      continue;
+
+    if (!buttonLongPressSent[i]) {
+      buttonLongPressSent[i] = true;
+      queueButtonEvent(i, BUTTON_EVENT_LONG_PRESS, now);
+    }
+    queueButtonEvent(i, BUTTON_EVENT_REPEAT, now);
+
+    // Repeat faster the longer the button is held
+    buttonRepeatTime[i] = now + buttonRepeatInterval[i];
+    buttonRepeatInterval[i] = max(buttonRepeatInterval[i] * 3 / 4, BUTTON_REPEAT_MIN_INTERVAL);
+  }
+}
+
+
+// Get the next button event
+// Returns false if there are no events.  Events that have been waiting for more than
+// BUTTON_EVENT_MAX_AGE are discarded, so buttons pressed while the sketch was busy (for
+// example, displaying a message) don't act on whatever is displayed next.
+boolean getButtonEvent(struct buttonEvent *event) {
+  uint8_t tail = buttonQueueTail;
+
+  while (tail != buttonQueueHead) {
+    event->button = buttonQueue[tail].button;
+    event->type = buttonQueue[tail].type;
+    event->time = buttonQueue[tail].time;
+    tail = (tail + 1) & (BUTTON_QUEUE_SIZE - 1);
+    buttonQueueTail = tail;
+    if ((uint16_t) ((uint16_t) millis() - event->time) <= BUTTON_EVENT_MAX_AGE)
+      return true;
+  }
+  return false;
+}
+
+
+// Determine if a button was pressed
+// Holding a button down generates more presses, which get faster the longer it is held.
+// Returns:
+//   CONTROLEO_BUTTON_NONE if no button are pressed
+//   CONTROLEO_BUTTON_TOP if the top button was pressed
+//   CONTROLEO_BUTTON_BOTTOM if the bottom button was pressed
+int getButton()
+{
+  int step;
+  return getButtonWithStep(1, 1, &step);
+}
+
+
+// Determine if a button was pressed, for settings that are changed by pressing a button
+// This works like getButton(), and also sets step to how much the setting should change.
+// Each press (and each repeat while the button is held) is a small step.  Once the button
+// has been held for BUTTON_LONG_PRESS_TIME the repeats are big steps, so a setting can be
+// moved across its whole range quickly
+int getButtonWithStep(int smallStep, int bigStep, int *step)
+{
+  static boolean isLongPress = false;
+  struct buttonEvent event;
+
+  while (getButtonEvent(&event)) {
+    switch (event.type) {
+      case BUTTON_EVENT_LONG_PRESS:
+        isLongPress = true;
+        break;
+      case BUTTON_EVENT_RELEASE:
+        isLongPress = false;
+        break;
+      case BUTTON_EVENT_PRESS:
+        isLongPress = false;
+        // Fall through
+      default:
+        *step = isLongPress? bigStep : smallStep;
+        // Click, without waiting for the tone to finish
+        startTone(event.button == CONTROLEO_BUTTON_TOP? TUNE_TOP_BUTTON_PRESS : TUNE_BOTTOM_BUTTON_PRESS);
+        return event.button;
+    }
+  }
+  return CONTROLEO_BUTTON_NONE;
+}
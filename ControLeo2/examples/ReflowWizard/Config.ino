@@ -15,17 +15,19 @@ boolean Config() {
   static int selectedServo = SETTING_SERVO_OPEN_DEGREES;
   static int bakeTemperature;
   static int bakeDuration;
+  static int temperatureSource;
   int oldSetupPhase = setupPhase;
+  int step;
   
   switch (setupPhase) {
     case 0:  // Set up the output types
       if (drawMenu) {
         drawMenu = false;
-        lcdPrintLine(0, "Dx is");
+        lcdPrintLine_P(0, PSTR("Dx is"));
         lcd.setCursor(1, 0);
         lcd.print(output);
         type = getSetting(SETTING_D4_TYPE - 4 + output);
-        lcdPrintLine(1, outputDescription[type]);
+        lcdPrintLine_P(1, getDescription(outputDescription, type));
       }
   
       // Was a button pressed?
@@ -33,7 +35,7 @@ boolean Config() {
         case CONTROLEO_BUTTON_TOP:
           // Move to the next type
           type = (type+1) % NO_OF_TYPES;
-          lcdPrintLine(1, outputDescription[type]);
+          lcdPrintLine_P(1, getDescription(outputDescription, type));
           break;
         case CONTROLEO_BUTTON_BOTTOM:
           // Save the type for this output
@@ -44,7 +46,7 @@ boolean Config() {
             lcd.setCursor(1, 0);
             lcd.print(output);
             type = getSetting(SETTING_D4_TYPE - 4 + output);
-            lcdPrintLine(1, outputDescription[type]);
+            lcdPrintLine_P(1, getDescription(outputDescription, type));
             break;
           }
           
@@ -58,17 +60,17 @@ boolean Config() {
     case 1:  // Get the maximum temperature
       if (drawMenu) {
         drawMenu = false;
-        lcdPrintLine(0, "Max temperature");
-        lcdPrintLine(1, "xxx\1C");
+        lcdPrintLine_P(0, PSTR("Max temperature"));
+        lcdPrintLine_P(1, PSTR("xxx\1C"));
         maxTemperature = getSetting(SETTING_MAX_TEMPERATURE);
         displayMaxTemperature(maxTemperature);
       }
       
-      // Was a button pressed?
-      switch (getButton()) {
+      // Was a button pressed?  Holding the top button goes up in steps of 10 degrees after a long press
+      switch (getButtonWithStep(1, 10, &step)) {
         case CONTROLEO_BUTTON_TOP:
           // Increase the temperature
-          maxTemperature++;
+          maxTemperature += step;
           if (maxTemperature > 280)
             maxTemperature = 175;
           displayMaxTemperature(maxTemperature);
@@ -84,8 +86,8 @@ boolean Config() {
     case 2:  // Get the servo open and closed settings
       if (drawMenu) {
         drawMenu = false;
-        lcdPrintLine(0, "Door servo");
-        lcdPrintLine(1, selectedServo == SETTING_SERVO_OPEN_DEGREES? "open:" : "closed:");
+        lcdPrintLine_P(0, PSTR("Door servo"));
+        lcdPrintLine_P(1, selectedServo == SETTING_SERVO_OPEN_DEGREES? PSTR("open:") : PSTR("closed:"));
         servoDegrees = getSetting(selectedServo);
         displayServoDegrees(servoDegrees);
         // Move the servo to the saved position
@@ -125,24 +127,20 @@ boolean Config() {
     case 3:  // Get bake temperature
       if (drawMenu) {
         drawMenu = false;
-        lcdPrintLine(0, "Bake temperature");
-        lcdPrintLine(1, "");
+        lcdPrintLine_P(0, PSTR("Bake temperature"));
+        lcdPrintLine_P(1, PSTR(""));
         bakeTemperature = getSetting(SETTING_BAKE_TEMPERATURE);
-        lcd.setCursor(0, 1);
-        lcd.print(bakeTemperature);
-        lcd.print("\1C ");
+        displayBakeTemperature(bakeTemperature);
       }
 
-      // Was a button pressed?
-      switch (getButton()) {
+      // Was a button pressed?  Holding the top button goes up in steps of 20 degrees after a long press
+      switch (getButtonWithStep(BAKE_TEMPERATURE_STEP, BAKE_TEMPERATURE_STEP * 4, &step)) {
         case CONTROLEO_BUTTON_TOP:
           // Increase the temperature
-          bakeTemperature += BAKE_TEMPERATURE_STEP;
+          bakeTemperature += step;
           if (bakeTemperature > BAKE_MAX_TEMPERATURE)
             bakeTemperature = BAKE_MIN_TEMPERATURE;
-          lcd.setCursor(0, 1);
-          lcd.print(bakeTemperature);
-          lcd.print("\1C ");
+          displayBakeTemperature(bakeTemperature);
           break;
         case CONTROLEO_BUTTON_BOTTOM:
           // Save the temperature
@@ -155,8 +153,8 @@ boolean Config() {
     case 4:  // Get bake duration
       if (drawMenu) {
         drawMenu = false;
-        lcdPrintLine(0, "Bake duration");
-        lcdPrintLine(1, "");
+        lcdPrintLine_P(0, PSTR("Bake duration"));
+        lcdPrintLine_P(1, PSTR(""));
         bakeDuration = getSetting(SETTING_BAKE_DURATION);
         displayDuration(0, getBakeSeconds(bakeDuration));
       }
@@ -176,17 +174,40 @@ boolean Config() {
       }
       break;      
 
-    case 5: // Restart learning mode
+    case 5:  // Get the thermocouple(s) used to control the oven
+      if (drawMenu) {
+        drawMenu = false;
+        lcdPrintLine_P(0, PSTR("Control temp on"));
+        temperatureSource = getSetting(SETTING_TEMPERATURE_SOURCE);
+        lcdPrintLine_P(1, getDescription(temperatureSourceDescription, temperatureSource));
+      }
+
+      // Was a button pressed?
+      switch (getButton()) {
+        case CONTROLEO_BUTTON_TOP:
+          // Move to the next temperature source
+          temperatureSource = (temperatureSource + 1) % NO_OF_TEMPERATURE_SOURCES;
+          lcdPrintLine_P(1, getDescription(temperatureSourceDescription, temperatureSource));
+          break;
+        case CONTROLEO_BUTTON_BOTTOM:
+          // Save the temperature source
+          setSetting(SETTING_TEMPERATURE_SOURCE, temperatureSource);
+          // Go to the next phase
+          setupPhase++;
+      }
+      break;
+
+    case 6: // Restart learning mode
       if (drawMenu) {
         drawMenu = false;
         if (getSetting(SETTING_LEARNING_MODE) == false) {
-          lcdPrintLine(0, "Restart learning");
-          lcdPrintLine(1, "mode?      No ->");
+          lcdPrintLine_P(0, PSTR("Restart learning"));
+          lcdPrintLine_P(1, PSTR("mode?      No ->"));
         }
         else
         {
-          lcdPrintLine(0, "Oven is in");
-          lcdPrintLine(1, "learning mode");
+          lcdPrintLine_P(0, PSTR("Oven is in"));
+          lcdPrintLine_P(1, PSTR("learning mode"));
         }
       }
       
@@ -203,19 +224,19 @@ boolean Config() {
        }
       break;
 
-     case 6: // Restore to factory settings
+     case 7: // Restore to factory settings
       if (drawMenu) {
         drawMenu = false;
-        lcdPrintLine(0, "Restore factory");
-        lcdPrintLine(1, "settings?  No ->");
+        lcdPrintLine_P(0, PSTR("Restore factory"));
+        lcdPrintLine_P(1, PSTR("settings?  No ->"));
       }
       
       // Was a button pressed?
       switch (getButton()) {
         case CONTROLEO_BUTTON_TOP:
           // Reset EEPROM to factory
-          lcdPrintLine(0, "Please wait ...");
-          lcdPrintLine(1, "");
+          lcdPrintLine_P(0, PSTR("Please wait ..."));
+          lcdPrintLine_P(1, PSTR(""));
           setSetting(SETTING_EEPROM_NEEDS_INIT, true);
           InitializeSettingsIfNeccessary();
 
@@ -232,7 +253,7 @@ boolean Config() {
   // Does the menu option need to be redrawn?
   if (oldSetupPhase != setupPhase)
     drawMenu = true;
-  if (setupPhase > 6) {
+  if (setupPhase > 7) {
     setupPhase = 0;
     return false;
   }
@@ -241,33 +262,53 @@ boolean Config() {
 
 
 void displayMaxTemperature(int maxTemperature) {
+  char buffer[4];
   lcd.setCursor(0, 1);
-  lcd.print(maxTemperature);
+  lcd.print(formatNumber(buffer, maxTemperature, 3));
+}
+
+
+void displayBakeTemperature(int bakeTemperature) {
+  char buffer[6];
+  lcd.setCursor(0, 1);
+  formatNumber(buffer, bakeTemperature, 3);
+  strcat(buffer, "\1C");
+  lcd.print(buffer);
 }
 
 
 void displayServoDegrees(int degrees) {
+  char buffer[5];
   lcd.setCursor(8, 1);
-  lcd.print(degrees);
-  lcd.print("\1 ");
+  formatNumber(buffer, degrees, 3);
+  strcat(buffer, "\1");
+  lcd.print(buffer);
 }
 
 
+// Display the duration as hours and minutes (like "18h05m") or minutes and seconds (like " 5m00s")
+// This is always 6 characters wide
 void displayDuration(int offset, uint16_t duration) {
-  lcd.setCursor(offset, 1);
+  char buffer[7];
   if (duration >= 3600) {
-    lcd.print((duration / 3600));
-    lcd.print("h ");
+    formatNumber(buffer, duration / 3600, 2);
+    formatNumber(buffer + 3, (duration % 3600) / 60, 2);
+    buffer[2] = 'h';
+    buffer[5] = 'm';
   }
-  lcd.print((duration % 3600) / 60);
-  lcd.print("m ");
-
-  if (duration < 3600) {
-    lcd.print(duration % 60);
-    lcd.print("s ");
+  else {
+    formatNumber(buffer, duration / 60, 2);
+    formatNumber(buffer + 3, duration % 60, 2);
+    buffer[2] = 'm';
+    buffer[5] = 's';
   }
-
-  lcd.print("   ");
+  // The units overwrote the terminating 0 written by formatNumber()
+  buffer[6] = 0;
+  // Show leading zeros in the second field
+  if (buffer[3] == ' ')
+    buffer[3] = '0';
+  lcd.setCursor(offset, 1);
+  lcd.print(buffer);
 }
 
 
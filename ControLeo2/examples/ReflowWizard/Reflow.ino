@@ -1,55 +1,54 @@
 // Reflow logic
 // Called from the main loop 20 times per second
 // This where the reflow logic is controlled
+//
+// The reflow engine (in the ControLeo2 library) runs the phases from pre-soak to cooling,
+// and turns the outputs on and off using the duty cycles for each phase.  The code here
+// builds the phases from the settings, decides what to do (and what to learn) when the
+// oven heats up too quickly or too slowly, and keeps the user informed.
 
 
-// Buffer used for Serial.print
-char debugBuffer[100];
-
 #define MILLIS_TO_SECONDS    ((long) 1000)
 
-// The data for each of pre-soak, soak and reflow phases
-struct phaseData {
-  int elementDutyCycle[4];    // Duty cycle for each output
-  int endTemperature;         // The temperature at which to move to the next reflow phase
-  int phaseMinDuration;       // The minimum number of seconds that this phase should run for
-  int phaseMaxDuration;       // The maximum number of seconds that this phase should run for
-};
+// The reflow engine runs from PHASE_PRESOAK to PHASE_COOLING_BOARDS_OUT.  Its phase 0 is PHASE_PRESOAK
+#define REFLOW_ENGINE_PHASES (PHASE_COOLING_BOARDS_OUT - PHASE_PRESOAK + 1)
+
+// One step of the duty cycle each time Reflow() is called
+ControLeo2_ReflowEngine reflowEngine(REFLOW_MODULATION_DUTY_CYCLE, 0);
+
+// Read from the settings when the reflow starts, and used to build the phases
+int reflowOutputType[4];
+int reflowMaxTemperature;
 
 
 // Return false to exit this mode
 boolean Reflow() {
   static int reflowPhase = PHASE_INIT;
-  static int outputType[4];
-  static int maxTemperature;
   static boolean learningMode;
-  static phaseData phase[PHASE_REFLOW+1];
-  static unsigned long phaseStartTime, reflowStartTime;
-  static int elementDutyCounter[4];
+  static unsigned long reflowStartTime;
   static int counter = 0;
-  static boolean firstTimeInPhase = true;
   
   double currentTemperature;
   unsigned long currentTime = millis();
-  int i, j;
-  int elementDutyStart = 0;
+  uint8_t event;
+  int i;
   
   // Read the temperature
   currentTemperature = getCurrentTemperature();
   if (THERMOCOUPLE_FAULT(currentTemperature)) {
-    lcdPrintLine(0, "Thermocouple err");
+    lcdPrintLine_P(0, PSTR("Thermocouple err"));
     Serial.print(F("Thermocouple Error: "));
     switch ((int) currentTemperature) {
       case FAULT_OPEN:
-        lcdPrintLine(1, "Fault open");
+        lcdPrintLine_P(1, PSTR("Fault open"));
         Serial.println(F("Fault open"));
         break;
       case FAULT_SHORT_GND:
-        lcdPrintLine(1, "Short to GND");
+        lcdPrintLine_P(1, PSTR("Short to GND"));
         Serial.println(F("Short to ground"));
         break;
       case FAULT_SHORT_VCC:
-        lcdPrintLine(1, "Short to VCC");
+        lcdPrintLine_P(1, PSTR("Short to VCC"));
         break;
     }
     
@@ -61,8 +60,8 @@ boolean Reflow() {
   // Abort the reflow if a button is pressed
   if (getButton() != CONTROLEO_BUTTON_NONE) {
     reflowPhase = PHASE_ABORT_REFLOW;
-    lcdPrintLine(0, "Aborting reflow");
-    lcdPrintLine(1, "Button pressed");
+    lcdPrintLine_P(0, PSTR("Aborting reflow"));
+    lcdPrintLine_P(1, PSTR("Button pressed"));
     Serial.println(F("Button pressed.  Aborting reflow ..."));
   }
   
@@ -72,8 +71,8 @@ boolean Reflow() {
       // Make sure the oven is cool.  This makes for more predictable/reliable reflows and
       // gives the SSR's time to cool down a bit.
       if (currentTemperature > 50.0) {
-        lcdPrintLine(0, "Temp > 50\1C");
-        lcdPrintLine(1, "Please wait...");
+        lcdPrintLine_P(0, PSTR("Temp > 50\1C"));
+        lcdPrintLine_P(1, PSTR("Please wait..."));
         Serial.println(F("Oven too hot to start reflow.  Please wait ..."));
         
         // Abort the reflow
@@ -83,17 +82,17 @@ boolean Reflow() {
     
       // Get the types for the outputs (elements, fan or unused)
       for (i=0; i<4; i++)
-        outputType[i] = getSetting(SETTING_D4_TYPE + i);
+        reflowOutputType[i] = getSetting(SETTING_D4_TYPE + i);
       // Get the maximum temperature
-      maxTemperature = getSetting(SETTING_MAX_TEMPERATURE);
+      reflowMaxTemperature = getSetting(SETTING_MAX_TEMPERATURE);
 
       // Don't allow reflow if the outputs are not configured
       for (i=0; i<4; i++)
-        if (isHeatingElement(outputType[i]))
+        if (isHeatingElement(reflowOutputType[i]))
           break;
       if (i == 4) {
-        lcdPrintLine(0, "Please configure");
-        lcdPrintLine(1, " outputs first! ");
+        lcdPrintLine_P(0, PSTR("Please configure"));
+        lcdPrintLine_P(1, PSTR(" outputs first! "));
         Serial.println(F("Outputs must be configured before reflow"));
         
         // Abort the reflow
@@ -101,12 +100,16 @@ boolean Reflow() {
         break;
       }
       
+      // If the settings have changed and there is a stored calibration for these outputs then use it
+      if (getSetting(SETTING_SETTINGS_CHANGED) == true && loadCalibration(reflowMaxTemperature))
+        setSetting(SETTING_SETTINGS_CHANGED, false);
+
       // If the settings have changed then set up learning mode
       if (getSetting(SETTING_SETTINGS_CHANGED) == true) {
         setSetting(SETTING_SETTINGS_CHANGED, false);
         // Tell the user that learning mode is being enabled
-        lcdPrintLine(0, "Settings changed");
-        lcdPrintLine(1, "Initializing...");
+        lcdPrintLine_P(0, PSTR("Settings changed"));
+        lcdPrintLine_P(1, PSTR("Initializing..."));
         Serial.println(F("Settings changed by user.  Reinitializing element duty cycles and enabling learning mode ..."));
         
         // Turn learning mode on
@@ -121,7 +124,7 @@ boolean Reflow() {
         // Reflow  = Heat the solder and pads rapidly
         //           Lots of heat from all directions
         for (i=0; i<4; i++) {
-          switch (outputType[i]) {
+          switch (reflowOutputType[i]) {
             case TYPE_UNUSED:
             case TYPE_COOLING_FAN:
               setSetting(SETTING_PRESOAK_D4_DUTY_CYCLE + i, 0);
@@ -154,321 +157,326 @@ boolean Reflow() {
         delay(3000);
       } // end of settings changed
       
-      // Read all the settings
-      learningMode = getSetting(SETTING_LEARNING_MODE);
-      for (i=PHASE_PRESOAK; i<=PHASE_REFLOW; i++) {
-        for (j=0; j<4; j++)
-          phase[i].elementDutyCycle[j] = getSetting(SETTING_PRESOAK_D4_DUTY_CYCLE + ((i-PHASE_PRESOAK) *4) + j);
-        // Time to peak temperature should be between 3.5 and 5.5 minutes.
-        // While J-STD-20 gives exact phase temperatures, the reading depends very much on the thermocouple used
-        // and its location.  Varying the phase temperatures as the max temperature changes allows for thermocouple
-        // variation.
-        // Keep in mind that there is a 2C error in the MAX31855, and typically a 3C error in the thermocouple.
-        switch(i) {
-          case PHASE_PRESOAK:
-            phase[i].endTemperature = maxTemperature * 3 / 5; // J-STD-20 gives 150C
-            phase[i].phaseMinDuration = 60;
-            phase[i].phaseMaxDuration = 110;
-            break;
-          case PHASE_SOAK:
-            phase[i].endTemperature = maxTemperature * 4 / 5; // J-STD-20 gives 200C
-            phase[i].phaseMinDuration = 80;
-            phase[i].phaseMaxDuration = 140;
-            break;
-          case PHASE_REFLOW:
-            phase[i].endTemperature = maxTemperature;
-            phase[i].phaseMinDuration = 60;
-            phase[i].phaseMaxDuration = 100;
-            break;
-        }
-      }
       // Let the user know if learning mode is on
+      learningMode = getSetting(SETTING_LEARNING_MODE);
       if (learningMode) {
-        lcdPrintLine(0, "Learning Mode");
-        lcdPrintLine(1, "is enabled");
+        lcdPrintLine_P(0, PSTR("Learning Mode"));
+        lcdPrintLine_P(1, PSTR("is enabled"));
         Serial.println(F("Learning mode is enabled.  Duty cycles may be adjusted automatically if necessary"));
         delay(3000);
       }
       
+      // Start the reflow.  The phases are read from the settings as they start
+      reflowStartTime = millis();
+      reflowEngine.setPhaseLoader(loadReflowPhase);
+      reflowEngine.setOutputLevelHook(getReflowOutputLevel);
+      reflowEngine.start(NULL, REFLOW_ENGINE_PHASES, reflowStartTime);
+      
       // Move to the next phase
       reflowPhase = PHASE_PRESOAK;
-      lcdPrintLine(0, phaseDescription[reflowPhase]);
-      lcdPrintLine(1, "");
+      startReflowPhase(reflowPhase);
+      break;
       
-      // Display information about this phase
-      serialDisplayPhaseData(reflowPhase, &phase[reflowPhase], outputType);
-
-      // Stagger the element start cycle to avoid abrupt changes in current draw
-      for (i=0; i< 4; i++) {
-        elementDutyCounter[i] = elementDutyStart;
-        // Turn the next element on (elementDutyCounter[i+1] == 0) when this element turns off (elementDutyCounter[i] == phase[reflowPhase].elementDutyCycle[i])
-        // For example, assume two element both at 20% duty cycle.  
-        //   The counter for the first starts at 0
-        //   The counter for the second should start at 80, because by the time counter 1 = 20 (1 turned off) counter 2 = 0 (counter 2 turned on)
-        elementDutyStart = (100 + elementDutyStart - phase[reflowPhase].elementDutyCycle[i]) % 100;
-      }
+    case PHASE_ABORT_REFLOW: // The reflow must be stopped now
+      Serial.println(F("Reflow is done!"));
+      // Turn all elements and fans off
+      reflowEngine.stop();
+      // Close the oven door now, over 3 seconds
+      setServoPosition(getSetting(SETTING_SERVO_CLOSED_DEGREES), 3000);
+      // Start next time with initialization
+      reflowPhase = PHASE_INIT;
+      // Wait for a bit to allow the user to read the last message
+      delay(3000);
+      // Return to the main menu
+      return false;
       
-      // Start the reflow and phase timers
-      reflowStartTime = millis();
-      phaseStartTime = reflowStartTime;
-      break;
+    default: // PHASE_PRESOAK to PHASE_COOLING_BOARDS_OUT
+      // Let the reflow engine switch the outputs and check for the end of the phase
+      event = reflowEngine.tick(currentTemperature, currentTime);
       
-    case PHASE_PRESOAK:
-    case PHASE_SOAK:
-    case PHASE_REFLOW:
-      // Has the ending temperature for this phase been reached?
-      if (currentTemperature >= phase[reflowPhase].endTemperature) {
-        // Was enough time spent in this phase?
-        if (currentTime - phaseStartTime < (unsigned long) (phase[reflowPhase].phaseMinDuration * MILLIS_TO_SECONDS)) {
-          sprintf(debugBuffer, "Warning: Oven heated up too quickly! Phase took %ld seconds.", (currentTime - phaseStartTime) / MILLIS_TO_SECONDS);
-          Serial.println(debugBuffer);
-          // Too little time was spent in this phase
-          if (learningMode) {
-            // Were the settings close to being right for this phase?  Within 8 seconds?
-            if (phase[reflowPhase].phaseMinDuration - ((currentTime - phaseStartTime) / 1000) < 8) {
-              // Reduce the duty cycle for the elements for this phase, but continue with this run
-              adjustPhaseDutyCycle(reflowPhase, -5);
-              displayAdjustmentsMadeContinue(true);
-            }
-            else {
-              // The oven heated up way too fast
-              adjustPhaseDutyCycle(reflowPhase, -8);
-
-              // Abort this run
-              lcdPrintPhaseMessage(reflowPhase, "Too fast");
-              lcdPrintLine(1, "Aborting ...");
-              reflowPhase = PHASE_ABORT_REFLOW;
-              
-              displayAdjustmentsMadeContinue(false);
-              break;
-            }
-          }
-          else {
-            // It is bad to make adjustments when not in learning mode, because this leads to inconsistent
-            // results.  However, this situation cannot be ignored.  Reduce the duty cycle slightly but
-            // don't abort the reflow
-            adjustPhaseDutyCycle(reflowPhase, -1);
-            Serial.println(F("Duty cycles lowered slightly for future runs"));
-          }
+      // The ending temperature for this phase was reached, but was enough time spent in this phase?
+      if (event == REFLOW_EVENT_TOO_FAST) {
+        if (!reflowTooFast(reflowPhase, currentTime - reflowEngine.phaseStartTime(), learningMode)) {
+          reflowPhase = PHASE_ABORT_REFLOW;
+          break;
         }
         // The temperature is high enough to move to the next phase
-        reflowPhase++;
-        firstTimeInPhase = true;
-        lcdPrintLine(0, phaseDescription[reflowPhase]);
-        phaseStartTime = millis();
-        // Stagger the element start cycle to avoid abrupt changes in current draw
-        for (i=0; i< 4; i++) {
-          elementDutyCounter[i] = elementDutyStart;
-          // Turn the next element on (elementDutyCounter[i+1] == 0) when this element turns off (elementDutyCounter[i] == phase[reflowPhase].elementDutyCycle[i])
-          // For example, assume two element both at 20% duty cycle.  
-          //   The counter for the first starts at 0
-          //   The counter for the second should start at 80, because by the time counter 1 = 20 (1 turned off) counter 2 = 0 (counter 2 turned on)
-          elementDutyStart = (100 + elementDutyStart - phase[reflowPhase].elementDutyCycle[i]) % 100;
-        }
-        // Display information about this phase
-        if (reflowPhase <= PHASE_REFLOW)
-          serialDisplayPhaseData(reflowPhase, &phase[reflowPhase], outputType);
-        break;
+        reflowEngine.nextPhase(currentTime);
+        event = REFLOW_EVENT_NEXT_PHASE;
       }
       
       // Has too much time been spent in this phase?
-      if (currentTime - phaseStartTime > (unsigned long) (phase[reflowPhase].phaseMaxDuration * MILLIS_TO_SECONDS)) {
-        Serial.print(F("Warning: Oven heated up too slowly! Current temperature is "));
-        Serial.println(currentTemperature);
-        // Still in learning mode?
-        if (learningMode) {
-          double temperatureDelta = phase[reflowPhase].endTemperature - currentTemperature;
-                    
-          if (temperatureDelta <= 5) {
-            // Almost made it!  Make a small adjustment to the duty cycles.  Continue with the reflow
-            adjustPhaseDutyCycle(reflowPhase, 4);
-            displayAdjustmentsMadeContinue(true);
-            phase[reflowPhase].phaseMaxDuration += 20;
-          }
-          else {
-            // A more dramatic temperature increase is needed for this phase
-            if (temperatureDelta < 10)
-              adjustPhaseDutyCycle(reflowPhase, 9);
-            else
-              adjustPhaseDutyCycle(reflowPhase, 18);
-              
-            // Abort this run
-            lcdPrintPhaseMessage(reflowPhase, "Too slow");
-            lcdPrintLine(1, "Aborting ...");
-            reflowPhase = PHASE_ABORT_REFLOW;
-            displayAdjustmentsMadeContinue(false);
-          }
-          break;
-        }
-        else {
-          // It is bad to make adjustments when not in learning mode, because this leads to inconsistent
-          // results.  However, this situation cannot be ignored.  Increase the duty cycle slightly but
-          // don't abort the reflow
-          adjustPhaseDutyCycle(reflowPhase, 1);
-          Serial.println(F("Duty cycles increased slightly for future runs"));
-            
-          // Turn all the elements on to get to temperature quickly
-          for (i=0; i<4; i++) {
-            switch(outputType[i]) {
-              case TYPE_BOTTOM_ELEMENT:
-                phase[reflowPhase].elementDutyCycle[i] = 100;
-                break;
-              case TYPE_TOP_ELEMENT:
-                phase[reflowPhase].elementDutyCycle[i] = 80;
-                break;
-              case TYPE_BOOST_ELEMENT:
-                phase[reflowPhase].elementDutyCycle[i] = 60;
-                break;
-                
-            }
-          }
-            
-          // Extend this phase by 10 seconds, or abort the reflow if it has taken too long
-          if (phase[reflowPhase].phaseMaxDuration < 200)
-            phase[reflowPhase].phaseMaxDuration += 10;
-          else {
-            lcdPrintPhaseMessage(reflowPhase, "Too slow");
-            lcdPrintLine(1, "Aborting ...");
-            reflowPhase = PHASE_ABORT_REFLOW;
-            Serial.println(F("Aborting reflow.  Oven cannot reach required temperature!"));
-          }
-        }
+      if (event == REFLOW_EVENT_TOO_SLOW && !reflowTooSlow(reflowPhase, currentTemperature, learningMode)) {
+        reflowPhase = PHASE_ABORT_REFLOW;
+        break;
       }
       
-      // Turn the output on or off based on its duty cycle
-      for (i=0; i< 4; i++) {
-        // Skip unused elements and cooling fan
-        if (outputType[i] == TYPE_UNUSED || outputType[i] == TYPE_COOLING_FAN)
-          continue;
-        // Turn all the elements on at the start of the presoak
-        if (reflowPhase == PHASE_PRESOAK && currentTemperature < (phase[reflowPhase].endTemperature * 3 / 5) - 10) {
-          digitalWrite(4 + i, HIGH);
-          continue;
-        }
-        // Turn the output on at 0, and off at the duty cycle value
-        if (elementDutyCounter[i] == 0)
-          digitalWrite(4 + i, HIGH);
-        if (elementDutyCounter[i] == phase[reflowPhase].elementDutyCycle[i])
-          digitalWrite(4 + i, LOW);
-        // Increment the duty counter
-        elementDutyCounter[i] = (elementDutyCounter[i] + 1) % 100;
+      if (event == REFLOW_EVENT_NEXT_PHASE) {
+        reflowPhase = reflowEngine.phase() + PHASE_PRESOAK;
+        startReflowPhase(reflowPhase);
+        break;
+      }
+      
+      // Once the temperature drops below 50C a new reflow can be started
+      if (event == REFLOW_EVENT_DONE) {
+        reflowPhase = PHASE_ABORT_REFLOW;
+        lcdPrintLine_P(0, PSTR("Reflow complete!"));
+        lcdPrintLine_P(1, PSTR(" "));
+        break;
       }
       
       // Don't consider the reflow process started until the temperature passes 50 degrees
-      if (currentTemperature < 50.0)
-        phaseStartTime = currentTime;
+      if (reflowPhase <= PHASE_REFLOW && currentTemperature < 50.0)
+        reflowEngine.restartPhaseTimer(currentTime);
       
-      // Update the displayed temperature roughly once per second
-      if (counter++ % 20 == 0)
-        displayReflowTemperature(currentTime, reflowStartTime, phaseStartTime, currentTemperature);
-      break;
-      
-    case PHASE_WAITING:  // Wait for solder to reach max temperatures and start cooling
-      if (firstTimeInPhase) {
-        firstTimeInPhase = false;
-        // Update the display
-        lcdPrintLine(0, "Reflow");
-        lcdPrintLine(1, " ");
-        Serial.println(F("******* Phase: Waiting *******"));
-        Serial.println(F("Turning all heating elements off ..."));
-        // Make sure all the elements are off (keep convection fans on)
-        for (int i=0; i<4; i++) {
-          if (outputType[i] != TYPE_CONVECTION_FAN)
-            digitalWrite(i+4, LOW);
-        }
-        // If we made it here it means the reflow is within the defined parameters.  Turn off learning mode
-        setSetting(SETTING_LEARNING_MODE, false);
-      }
       // Update the displayed temperature roughly once per second
       if (counter++ % 20 == 0) {
-        displayReflowTemperature(currentTime, reflowStartTime, phaseStartTime, currentTemperature);
-        // Countdown to the end of this phase
-        lcd.setCursor(13, 0);
-        lcd.print(40 - ((currentTime - phaseStartTime) / MILLIS_TO_SECONDS));
-        lcd.print("s ");
+        displayReflowTemperature(currentTime, reflowStartTime, reflowEngine.phaseStartTime(), currentTemperature);
+        // Countdown to the end of the waiting phase
+        if (reflowPhase == PHASE_WAITING) {
+          char buffer[4];
+          lcd.setCursor(13, 0);
+          formatNumber(buffer, reflowEngine.currentPhase()->maxDuration - (long) ((currentTime - reflowEngine.phaseStartTime()) / MILLIS_TO_SECONDS), 2);
+          strcat(buffer, "s");
+          lcd.print(buffer);
+        }
       }
-       
+      break;
+  }
+  
+  return true;
+}
+
+
+// Called by the reflow engine when each phase starts
+void loadReflowPhase(uint8_t enginePhase, struct ReflowEnginePhase *data) {
+  int phase = enginePhase + PHASE_PRESOAK;
+  
+  data->flags = 0;
+  data->minDuration = 0;
+  data->maxDuration = 0;
+  for (int i=0; i<4; i++) {
+    if (phase <= PHASE_REFLOW) {
+      // Unused outputs and the cooling fan stay off while heating
+      if (reflowOutputType[i] == TYPE_UNUSED || reflowOutputType[i] == TYPE_COOLING_FAN)
+        data->level[i] = 0;
+      else
+        data->level[i] = getSetting(SETTING_PRESOAK_D4_DUTY_CYCLE + ((phase-PHASE_PRESOAK) *4) + i);
+    }
+    else {
+      // All the elements are off (keep convection fans on).  The cooling fan comes on once the door is opened
+      if (reflowOutputType[i] == TYPE_CONVECTION_FAN || (phase >= PHASE_COOLING_BOARDS_IN && reflowOutputType[i] == TYPE_COOLING_FAN))
+        data->level[i] = 100;
+      else
+        data->level[i] = 0;
+    }
+  }
+  
+  // Time to peak temperature should be between 3.5 and 5.5 minutes.
+  // While J-STD-20 gives exact phase temperatures, the reading depends very much on the thermocouple used
+  // and its location.  Varying the phase temperatures as the max temperature changes allows for thermocouple
+  // variation.
+  // Keep in mind that there is a 2C error in the MAX31855, and typically a 3C error in the thermocouple.
+  switch (phase) {
+    case PHASE_PRESOAK:
+      data->exitTemperature = reflowMaxTemperature * 3 / 5; // J-STD-20 gives 150C
+      data->minDuration = 60;
+      data->maxDuration = 110;
+      break;
+    case PHASE_SOAK:
+      data->exitTemperature = reflowMaxTemperature * 4 / 5; // J-STD-20 gives 200C
+      data->minDuration = 80;
+      data->maxDuration = 140;
+      break;
+    case PHASE_REFLOW:
+      data->exitTemperature = reflowMaxTemperature;
+      data->minDuration = 60;
+      data->maxDuration = 100;
+      break;
+    case PHASE_WAITING:
       // Wait in this phase for 40 seconds.  The maximum time in liquidous state is 150 seconds
       // Max 90 seconds in PHASE_REFLOW + 40 seconds in PHASE_WAITING + some cool down time in PHASE_COOLING_BOARDS_IN is less than 150 seconds.
-      if (currentTime - phaseStartTime > 40 * MILLIS_TO_SECONDS) {
-        reflowPhase = PHASE_COOLING_BOARDS_IN;
-        firstTimeInPhase = true;
-      }
+      data->flags = REFLOW_PHASE_TIMED;
+      data->maxDuration = 40;
+      break;
+    case PHASE_COOLING_BOARDS_IN:
+      // Boards can be removed once the temperature drops below 100C
+      data->flags = REFLOW_PHASE_FALLING;
+      data->exitTemperature = 100;
+      break;
+    case PHASE_COOLING_BOARDS_OUT:
+      // Once the temperature drops below 50C a new reflow can be started
+      data->flags = REFLOW_PHASE_FALLING;
+      data->exitTemperature = 50;
+      break;
+  }
+}
+
+
+// Called by the reflow engine before switching each output
+// Turn all the elements on at the start of the presoak (the engine's phase 0)
+uint8_t getReflowOutputLevel(uint8_t output, uint8_t level, double temperature) {
+  // Skip unused outputs and the cooling fan
+  if (reflowOutputType[output] == TYPE_UNUSED || reflowOutputType[output] == TYPE_COOLING_FAN)
+    return level;
+  if (reflowEngine.phase() == 0 && temperature < (reflowEngine.currentPhase()->exitTemperature * 3 / 5) - 10)
+    return 100;
+  return level;
+}
+
+
+// Let the user know that a new phase has started
+void startReflowPhase(int phase) {
+  switch (phase) {
+    case PHASE_PRESOAK:
+    case PHASE_SOAK:
+    case PHASE_REFLOW:
+      lcdPrintLine_P(0, getDescription(phaseDescription, phase));
+      if (phase == PHASE_PRESOAK)
+        lcdPrintLine_P(1, PSTR(""));
+      // Display information about this phase
+      serialDisplayPhaseData(phase, reflowEngine.currentPhase());
+      break;
+      
+    case PHASE_WAITING:  // Wait for solder to reach max temperatures and start cooling
+      // Update the display
+      lcdPrintLine_P(0, PSTR("Reflow"));
+      lcdPrintLine_P(1, PSTR(" "));
+      Serial.println(F("******* Phase: Waiting *******"));
+      Serial.println(F("Turning all heating elements off ..."));
+      // If we made it here it means the reflow is within the defined parameters.  Turn off learning mode
+      setSetting(SETTING_LEARNING_MODE, false);
+      // Save the duty cycles so they can be used again if the maximum temperature is changed back to this one
+      storeCalibration(reflowMaxTemperature);
       break;
       
     case PHASE_COOLING_BOARDS_IN: // Start cooling the oven.  The boards must remain in the oven to cool
-      if (firstTimeInPhase) {
-        firstTimeInPhase = false;
-        // Update the display
-        lcdPrintLine(0, "Cool - open door");
-        Serial.println(F("******* Phase: Cooling *******"));
-        Serial.println(F("Open the oven door ..."));
-        // If a servo is attached, use it to open the door over 10 seconds
-        setServoPosition(getSetting(SETTING_SERVO_OPEN_DEGREES), 10000);
-        // Play a tune to let the user know the door should be opened
-        playTones(TUNE_REFLOW_DONE);
-
-        // Turn on the cooling fan
-        for (int i=0; i<4; i++) {
-          if (outputType[i] == TYPE_COOLING_FAN)
-            digitalWrite(i+4, HIGH);
-        }
-      }
-      // Update the temperature roughly once per second
-      if (counter++ % 20 == 0)
-        displayReflowTemperature(currentTime, reflowStartTime, phaseStartTime, currentTemperature);
-        
-      // Boards can be removed once the temperature drops below 100C
-      if (currentTemperature < 100.0) {
-        reflowPhase = PHASE_COOLING_BOARDS_OUT;
-        firstTimeInPhase = true;
-      }
+      // Update the display
+      lcdPrintLine_P(0, PSTR("Cool - open door"));
+      Serial.println(F("******* Phase: Cooling *******"));
+      Serial.println(F("Open the oven door ..."));
+      // If a servo is attached, use it to open the door over 10 seconds
+      setServoPosition(getSetting(SETTING_SERVO_OPEN_DEGREES), 10000);
+      // Play a tune to let the user know the door should be opened
+      playTones(TUNE_REFLOW_DONE);
       break;
       
     case PHASE_COOLING_BOARDS_OUT: // The boards can be removed without dislodging components now
-      if (firstTimeInPhase) {
-        firstTimeInPhase = false;
-        // Update the display
-        lcdPrintLine(0, "Okay to remove  ");
-        lcdPrintLine(1, "          boards");
-        // Play a tune to let the user know the boards can be removed
-        playTones(TUNE_REMOVE_BOARDS);
-      }
-      // Update the temperature roughly once per second
-      if (counter++ % 20 == 0)
-        displayReflowTemperature(currentTime, reflowStartTime, phaseStartTime, currentTemperature);
-        
-      // Once the temperature drops below 50C a new reflow can be started
-      if (currentTemperature < 50.0) {
-        reflowPhase = PHASE_ABORT_REFLOW;
-        lcdPrintLine(0, "Reflow complete!");
-        lcdPrintLine(1, " ");
-      }
+      // Update the display
+      lcdPrintLine_P(0, PSTR("Okay to remove  "));
+      lcdPrintLine_P(1, PSTR("          boards"));
+      // Play a tune to let the user know the boards can be removed
+      playTones(TUNE_REMOVE_BOARDS);
       break;
+  }
+}
+
+
+// The ending temperature for this phase was reached before the phase's minimum duration
+// Returns false if the reflow should be aborted
+boolean reflowTooFast(int phase, unsigned long phaseTime, boolean learningMode) {
+  Serial.print(F("Warning: Oven heated up too quickly! Phase took "));
+  Serial.print(phaseTime / MILLIS_TO_SECONDS);
+  Serial.println(F(" seconds."));
+  
+  // It is bad to make adjustments when not in learning mode, because this leads to inconsistent
+  // results.  However, this situation cannot be ignored.  Reduce the duty cycle slightly but
+  // don't abort the reflow
+  if (!learningMode) {
+    adjustPhaseDutyCycle(phase, -1);
+    Serial.println(F("Duty cycles lowered slightly for future runs"));
+    return true;
+  }
+  
+  // Were the settings close to being right for this phase?  Within 8 seconds?
+  if (reflowEngine.currentPhase()->minDuration - (phaseTime / MILLIS_TO_SECONDS) < 8) {
+    // Reduce the duty cycle for the elements for this phase, but continue with this run
+    adjustPhaseDutyCycle(phase, -5);
+    displayAdjustmentsMadeContinue(true);
+    return true;
+  }
+  
+  // The oven heated up way too fast
+  adjustPhaseDutyCycle(phase, -8);
+  
+  // Abort this run
+  lcdPrintPhaseMessage(phase, "Too fast");
+  lcdPrintLine_P(1, PSTR("Aborting ..."));
+  displayAdjustmentsMadeContinue(false);
+  return false;
+}
+
+
+// The phase has taken longer than its maximum duration
+// Returns false if the reflow should be aborted
+boolean reflowTooSlow(int phase, double currentTemperature, boolean learningMode) {
+  Serial.print(F("Warning: Oven heated up too slowly! Current temperature is "));
+  Serial.println(currentTemperature);
+  
+  // Still in learning mode?
+  if (learningMode) {
+    double temperatureDelta = reflowEngine.currentPhase()->exitTemperature - currentTemperature;
+    
+    if (temperatureDelta <= 5) {
+      // Almost made it!  Make a small adjustment to the duty cycles.  Continue with the reflow
+      adjustPhaseDutyCycle(phase, 4);
+      displayAdjustmentsMadeContinue(true);
+      reflowEngine.extendPhase(20);
+      return true;
+    }
+    
+    // A more dramatic temperature increase is needed for this phase
+    if (temperatureDelta < 10)
+      adjustPhaseDutyCycle(phase, 9);
+    else
+      adjustPhaseDutyCycle(phase, 18);
       
-    case PHASE_ABORT_REFLOW: // The reflow must be stopped now
-      Serial.println(F("Reflow is done!"));
-      // Turn all elements and fans off
-      for (i = 4; i < 8; i++)
-        digitalWrite(i, LOW);
-      // Close the oven door now, over 3 seconds
-      setServoPosition(getSetting(SETTING_SERVO_CLOSED_DEGREES), 3000);
-      // Start next time with initialization
-      reflowPhase = PHASE_INIT;
-      // Wait for a bit to allow the user to read the last message
-      delay(3000);
-      // Return to the main menu
-      return false;
+    // Abort this run
+    lcdPrintPhaseMessage(phase, "Too slow");
+    lcdPrintLine_P(1, PSTR("Aborting ..."));
+    displayAdjustmentsMadeContinue(false);
+    return false;
   }
   
-  return true;
+  // It is bad to make adjustments when not in learning mode, because this leads to inconsistent
+  // results.  However, this situation cannot be ignored.  Increase the duty cycle slightly but
+  // don't abort the reflow
+  adjustPhaseDutyCycle(phase, 1);
+  Serial.println(F("Duty cycles increased slightly for future runs"));
+    
+  // Turn all the elements on to get to temperature quickly
+  for (int i=0; i<4; i++) {
+    switch(reflowOutputType[i]) {
+      case TYPE_BOTTOM_ELEMENT:
+        reflowEngine.setOutputLevel(i, 100);
+        break;
+      case TYPE_TOP_ELEMENT:
+        reflowEngine.setOutputLevel(i, 80);
+        break;
+      case TYPE_BOOST_ELEMENT:
+        reflowEngine.setOutputLevel(i, 60);
+        break;
+    }
+  }
+    
+  // Extend this phase by 10 seconds, or abort the reflow if it has taken too long
+  if (reflowEngine.currentPhase()->maxDuration < 200) {
+    reflowEngine.extendPhase(10);
+    return true;
+  }
+  lcdPrintPhaseMessage(phase, "Too slow");
+  lcdPrintLine_P(1, PSTR("Aborting ..."));
+  Serial.println(F("Aborting reflow.  Oven cannot reach required temperature!"));
+  return false;
 }
 
 
 // Adjust the duty cycle for all elements by the given adjustment value
 void adjustPhaseDutyCycle(int phase, int adjustment) {
-  sprintf(debugBuffer, "Adjusting duty cycles for %s phase by %d", phaseDescription[phase], adjustment);
-  Serial.println(debugBuffer);
+  Serial.print(F("Adjusting duty cycles for "));
+  Serial.print(FLASH_STRING(getDescription(phaseDescription, phase)));
+  Serial.print(F(" phase by "));
+  Serial.println(adjustment);
   // Loop through the 4 outputs
   for (int i=0; i< 4; i++) {
     int dutySetting = SETTING_PRESOAK_D4_DUTY_CYCLE + ((phase-1) * 4) + i;
@@ -493,8 +501,14 @@ void adjustPhaseDutyCycle(int phase, int adjustment) {
         continue;
     }
     
-    sprintf(debugBuffer, "D%d (%s) changed from %d to %d", i+4, outputDescription[getSetting(SETTING_D4_TYPE + i)], getSetting(dutySetting), newDutyCycle);
-    Serial.println(debugBuffer);
+    Serial.print(F("D"));
+    Serial.print(i+4);
+    Serial.print(F(" ("));
+    Serial.print(FLASH_STRING(getDescription(outputDescription, getSetting(SETTING_D4_TYPE + i))));
+    Serial.print(F(") changed from "));
+    Serial.print(getSetting(dutySetting));
+    Serial.print(F(" to "));
+    Serial.println(newDutyCycle);
     // Save the new duty cycle
     setSetting(dutySetting, newDutyCycle);
   }
@@ -507,25 +521,36 @@ void lcdPrintPhaseMessage(int phase, const char* str) {
   // Sanity check on the parameters
   if (!str || strlen(str) > 8)
     return;
-  sprintf(buffer, "%s:%s", phaseDescription[phase], str);
+  strcpy_P(buffer, getDescription(phaseDescription, phase));
+  strcat(buffer, ":");
+  strcat(buffer, str);
   lcdPrintLine(0, buffer);
 }
 
 
 // Print data about the phase to the serial port
-void serialDisplayPhaseData(int phase, struct phaseData *pd, int *outputType) {
-  sprintf(debugBuffer, "******* Phase: %s *******", phaseDescription[phase]);
-  Serial.println(debugBuffer);
-  sprintf(debugBuffer, "Minimum duration = %d seconds", pd->phaseMinDuration);
-  Serial.println(debugBuffer);
-  sprintf(debugBuffer, "Maximum duration = %d seconds", pd->phaseMaxDuration);
-  Serial.println(debugBuffer);
-  sprintf(debugBuffer, "End temperature = %d Celsius", pd->endTemperature);
-  Serial.println(debugBuffer);
+void serialDisplayPhaseData(int phase, const struct ReflowEnginePhase *pd) {
+  Serial.print(F("******* Phase: "));
+  Serial.print(FLASH_STRING(getDescription(phaseDescription, phase)));
+  Serial.println(F(" *******"));
+  Serial.print(F("Minimum duration = "));
+  Serial.print(pd->minDuration);
+  Serial.println(F(" seconds"));
+  Serial.print(F("Maximum duration = "));
+  Serial.print(pd->maxDuration);
+  Serial.println(F(" seconds"));
+  Serial.print(F("End temperature = "));
+  Serial.print(pd->exitTemperature);
+  Serial.println(F(" Celsius"));
   Serial.println(F("Duty cycles: "));
   for (int i=0; i<4; i++) {
-    sprintf(debugBuffer, "  D%d = %d  (%s)", i+4, pd->elementDutyCycle[i], outputDescription[outputType[i]]);
-    Serial.println(debugBuffer);
+    Serial.print(F("  D"));
+    Serial.print(i+4);
+    Serial.print(F(" = "));
+    Serial.print(pd->level[i]);
+    Serial.print(F("  ("));
+    Serial.print(FLASH_STRING(getDescription(outputDescription, reflowOutputType[i])));
+    Serial.println(F(")"));
   }
 }
 
@@ -535,10 +560,14 @@ void displayReflowTemperature(unsigned long currentTime, unsigned long startTime
   // Display the temperature on the LCD screen
   displayTemperature(temperature);
 
+  char buffer[FORMAT_MAX_DIGITS + 1];
+
   // Write the time and temperature to the serial port, for graphing or analysis on a PC
-  sprintf(debugBuffer, "%ld, %ld, ", (currentTime - startTime) / MILLIS_TO_SECONDS, (currentTime - phaseTime) / MILLIS_TO_SECONDS);
-  Serial.print(debugBuffer);
-  Serial.println(temperature);
+  Serial.print((currentTime - startTime) / MILLIS_TO_SECONDS);
+  Serial.print(F(", "));
+  Serial.print((currentTime - phaseTime) / MILLIS_TO_SECONDS);
+  Serial.print(F(", "));
+  Serial.println(formatTemperature(buffer, temperature, 0));
 }
 
 
@@ -2,6 +2,13 @@
 #ifndef REFLOW_WIZARD_H
 #define REFLOW_WIZARD_H
 
+#include <avr/pgmspace.h>
+
+// There is only 2.5Kb of RAM, so the description tables are stored in flash (PROGMEM)
+// Get a string from one of these tables.  Use lcdPrintLine_P() or FLASH_STRING() to display it
+#define getDescription(table, i)             ((const char *) pgm_read_word(&(table)[i]))
+#define FLASH_STRING(str)                    ((const __FlashStringHelper *) (str))
+
 // Main menu modes
 #define MODE_TESTING                         0
 #define MODE_CONFIG                          1
@@ -21,7 +28,13 @@
 #define NO_OF_TYPES                          6
 #define isHeatingElement(x)                  (x == TYPE_TOP_ELEMENT || x == TYPE_BOTTOM_ELEMENT || x == TYPE_BOOST_ELEMENT)
 
-const char *outputDescription[NO_OF_TYPES] = {"Unused", "Top", "Bottom", "Boost", "Convection Fan","Cooling Fan"};
+const char outputUnused[] PROGMEM = "Unused";
+const char outputTop[] PROGMEM = "Top";
+const char outputBottom[] PROGMEM = "Bottom";
+const char outputBoost[] PROGMEM = "Boost";
+const char outputConvectionFan[] PROGMEM = "Convection Fan";
+const char outputCoolingFan[] PROGMEM = "Cooling Fan";
+const char * const outputDescription[NO_OF_TYPES] PROGMEM = {outputUnused, outputTop, outputBottom, outputBoost, outputConvectionFan, outputCoolingFan};
 
 // Phases of reflow
 #define PHASE_INIT                           0    // Variable initialization
@@ -39,8 +52,18 @@ const char *outputDescription[NO_OF_TYPES] = {"Unused", "Top", "Bottom", "Boost"
 #define BAKING_PHASE_START_COOLING           3    // Start the cooling process
 #define BAKING_PHASE_COOLING                 4    // Wait till the oven has cooled down to 50°C
 #define BAKING_PHASE_ABORT                   5    // Baking was aborted or completed
-const char *phaseDescription[] = {"", "Presoak", "Soak", "Reflow", "Waiting", "Cooling", "Cool - open door", "Abort"};
-const char *bakingPhaseDescription[] = {"", "Heating", "Baking", "", "Cooling", ""};
+const char phaseEmpty[] PROGMEM = "";
+const char phasePresoak[] PROGMEM = "Presoak";
+const char phaseSoak[] PROGMEM = "Soak";
+const char phaseReflow[] PROGMEM = "Reflow";
+const char phaseWaiting[] PROGMEM = "Waiting";
+const char phaseCooling[] PROGMEM = "Cooling";
+const char phaseCoolingOpenDoor[] PROGMEM = "Cool - open door";
+const char phaseAbort[] PROGMEM = "Abort";
+const char phaseHeating[] PROGMEM = "Heating";
+const char phaseBaking[] PROGMEM = "Baking";
+const char * const phaseDescription[] PROGMEM = {phaseEmpty, phasePresoak, phaseSoak, phaseReflow, phaseWaiting, phaseCooling, phaseCoolingOpenDoor, phaseAbort};
+const char * const bakingPhaseDescription[] PROGMEM = {phaseEmpty, phaseHeating, phaseBaking, phaseEmpty, phaseCooling, phaseEmpty};
 
 // Tunes used to indication various actions or status
 #define TUNE_STARTUP                         0
@@ -50,6 +73,24 @@ const char *bakingPhaseDescription[] = {"", "Heating", "Baking", "", "Cooling",
 #define TUNE_REMOVE_BOARDS                   4
 #define MAX_TUNES                            5
 
+// Button events (see Buttons.ino)
+#define BUTTON_EVENT_PRESS                   0    // The button was pressed
+#define BUTTON_EVENT_RELEASE                 1    // The button was released
+#define BUTTON_EVENT_LONG_PRESS              2    // The button has been held down for BUTTON_LONG_PRESS_TIME
+#define BUTTON_EVENT_REPEAT                  3    // The button is still held down.  These get faster the longer it is held
+#define BUTTON_QUEUE_SIZE                    8    // Must be a power of 2
+#define BUTTON_DEBOUNCE_TIME                 20   // Changes within this many ms of the last one are contact bounce
+#define BUTTON_LONG_PRESS_TIME               600  // Hold time (ms) before the long press and first repeat
+#define BUTTON_REPEAT_START_INTERVAL         250  // Time (ms) between the first repeats ...
+#define BUTTON_REPEAT_MIN_INTERVAL           60   // ... which speed up to this.  Slower than the main loop so they don't pile up
+#define BUTTON_EVENT_MAX_AGE                 500  // Events not read within this many ms are discarded
+
+struct buttonEvent {
+  uint8_t button;                                 // CONTROLEO_BUTTON_TOP or CONTROLEO_BUTTON_BOTTOM
+  uint8_t type;                                   // BUTTON_EVENT_xxx
+  uint16_t time;                                  // Lower 16 bits of millis() when it happened
+};
+
 // EEPROM settings
 // Remember that EEPROM initializes to 0xFF after flashing the bootloader
 #define SETTING_EEPROM_NEEDS_INIT             0    // EEPROM will be initialized to 0 at first run
@@ -61,6 +102,7 @@ const char *bakingPhaseDescription[] = {"", "Heating", "Baking", "", "Cooling",
 #define SETTING_SETTINGS_CHANGED              6    // Settings have changed.  Relearn duty cycles
 #define SETTING_BAKE_TEMPERATURE              7    // The baking temperature (divided by 5)
 #define SETTING_BAKE_DURATION                 8    // The baking duration (see getBakeSeconds)
+#define SETTING_TEMPERATURE_SOURCE            9    // The thermocouple(s) used to control the oven (see TEMPERATURE_SOURCE_xxx)
 
 // Learned settings
 #define SETTING_LEARNING_MODE                 10   // ControLeo is learning oven response and will make adjustments
@@ -79,13 +121,47 @@ const char *bakingPhaseDescription[] = {"", "Heating", "Baking", "", "Cooling",
 #define SETTING_SERVO_OPEN_DEGREES            23   // The position the servo should be in when the door is open
 #define SETTING_SERVO_CLOSED_DEGREES          24   // The position the servo should be in when the door is closed
 
+// Learned bake duty cycles
+// One byte per bake temperature (BAKE_MIN_TEMPERATURE to BAKE_MAX_TEMPERATURE in BAKE_TEMPERATURE_STEP increments).
+// A value of 0 means the duty cycle for that temperature hasn't been learned yet.
+#define SETTING_BAKE_DUTY_CYCLE_TABLE         30   // Steady-state duty cycle for BAKE_MIN_TEMPERATURE (first of BAKE_DUTY_CYCLE_ENTRIES)
+
+// Stored reflow calibrations
+// Each slot holds a complete set of learned duty cycles, tagged with the maximum temperature and output types
+// they were learned with.  A maximum temperature of 0 means the slot is empty.
+#define SETTING_CALIBRATION_STORE             64   // First byte of the first calibration slot
+#define CALIBRATION_SLOTS                     8    // Number of calibrations that can be stored
+#define CALIBRATION_SLOT_SIZE                 16   // Bytes used by each calibration slot
+#define CALIBRATION_MAX_TEMPERATURE           0    // Offset of the maximum temperature (stored temp is offset by 150 degrees)
+#define CALIBRATION_OUTPUT_TYPES              1    // Offset of the output types and temperature source (2 bytes)
+#define CALIBRATION_DUTY_CYCLES               3    // Offset of the presoak, soak and reflow duty cycles (12 bytes)
+
 #define TEMPERATURE_OFFSET                    150  // To allow temperature to be saved in 8-bits (0-255)
 #define BAKE_TEMPERATURE_STEP                 5    // Allows the storing of the temperature range in one byte
 #define BAKE_MAX_DURATION                     176  // 176 = 18 hours (see getBakeSeconds)
 #define BAKE_MIN_TEMPERATURE                  40   // Minimum temperature for baking
 #define BAKE_MAX_TEMPERATURE                  200  // Maximum temperature for baking
+#define BAKE_DUTY_CYCLE_ENTRIES               ((BAKE_MAX_TEMPERATURE - BAKE_MIN_TEMPERATURE) / BAKE_TEMPERATURE_STEP + 1)
+#define BAKE_DUTY_CYCLE_SETTLE_TIME           600  // Seconds without a duty cycle change before it is considered learned
 
 // Thermocouple
 #define THERMOCOUPLE_FAULT(x)                 (x == FAULT_OPEN || x == FAULT_SHORT_GND || x == FAULT_SHORT_VCC)
+#define AIR_THERMOCOUPLE                      0    // The thermocouple on the ControLeo2 board, measuring air temperature
+#define BOARD_THERMOCOUPLE                    1    // Optional thermocouple attached to a PCB in the oven
+#define NUM_THERMOCOUPLES                     2    // Exactly two MAX31855's are supported: air (CS on D9) and board (CS on D12)
+#define BOARD_THERMOCOUPLE_CS_PIN             12   // Chip select for the board thermocouple's MAX31855
+
+// The temperature used to control the oven
+#define TEMPERATURE_SOURCE_AIR                0    // Air temperature only (the default)
+#define TEMPERATURE_SOURCE_BOARD              1    // Board temperature only
+#define TEMPERATURE_SOURCE_MAX                2    // The higher of the air and board temperatures
+#define TEMPERATURE_SOURCE_WEIGHTED           3    // Weighted average of the air and board temperatures
+#define NO_OF_TEMPERATURE_SOURCES             4
+#define BOARD_TEMPERATURE_WEIGHT              75   // Percentage weight given to the board temperature
+const char sourceAir[] PROGMEM = "Air";
+const char sourceBoard[] PROGMEM = "Board";
+const char sourceMax[] PROGMEM = "Max(air,board)";
+const char sourceWeighted[] PROGMEM = "Weighted";
+const char * const temperatureSourceDescription[NO_OF_TEMPERATURE_SOURCES] PROGMEM = {sourceAir, sourceBoard, sourceMax, sourceWeighted};
 
 #endif // REFLOW_WIZARD_H
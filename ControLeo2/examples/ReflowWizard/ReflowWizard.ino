@@ -111,6 +111,7 @@
 
 
 // ***** INCLUDES *****
+#include <avr/sleep.h>
 #include <ControLeo2.h>
 #include "ReflowWizard.h"
 
@@ -120,18 +121,41 @@ ControLeo2_LiquidCrystal lcd;
 
 int mode = 0;
 
+// How much of the main loop's time is spent asleep, waiting for the next loop
+uint8_t loopIdlePercent = 100;        // During the last second
+uint8_t loopMinIdlePercent = 100;     // During the busiest second since the last report.  This is the headroom left
+
+// How long after reset ControLeo2 could control the oven: the outputs are off and the air
+// thermocouple has been read.  Measured by millis(), so the time spent in the bootloader isn't
+// included.  Set by the Timer 1 interrupt on the first read, even if it is a fault (see Thermocouple.ino)
+volatile unsigned long controllableTime = 0;
+extern volatile boolean hasReading[];
+
+#define SPLASH_SCREEN_TIME    3000    // How long the splash screen is shown after reset (milliseconds)
+
 void setup() {
   // *********** Start of ControLeo2 initialization ***********
-  // Set up the buzzer and buttons
-  pinMode(CONTROLEO_BUZZER_PIN, OUTPUT);
-  pinMode(CONTROLEO_BUTTON_TOP_PIN, INPUT_PULLUP);
-  pinMode(CONTROLEO_BUTTON_BOTTOM_PIN, INPUT_PULLUP);
-  // Set the relays as outputs and turn them off
+  // Set the relays as outputs and turn them off.  This is done first, in case ControLeo2
+  // was reset (for example, by a brown-out) while the elements were on
   // The relay outputs are on D4 to D7 (4 outputs)
   for (int i=4; i<8; i++) {
     pinMode(i, OUTPUT);
     digitalWrite(i, LOW);
   }
+  
+  // Initialize the timer used to take thermocouple readings and control the servo.  The
+  // first reading is taken 20ms later, while the LCD is being set up.  The board thermocouple
+  // is only read if it is used to control the oven
+  setTemperatureSource(getSetting(SETTING_TEMPERATURE_SOURCE));
+  initializeTimer();
+  
+  // Set up the buzzer and buttons
+  pinMode(CONTROLEO_BUZZER_PIN, OUTPUT);
+  pinMode(CONTROLEO_BUTTON_TOP_PIN, INPUT_PULLUP);
+  pinMode(CONTROLEO_BUTTON_BOTTOM_PIN, INPUT_PULLUP);
+  // Start capturing button presses
+  initializeButtons();
+  
   // Set up the LCD's number of rows and columns 
   lcd.begin(16, 2);
   // Create the degree symbol for the LCD - you can display this with lcd.print("\1") or lcd.write(1)
@@ -141,19 +165,25 @@ void setup() {
   
   // Log data to the computer using USB
   Serial.begin(57600);
-  
-  // Initialize the timer used to take thermocouple readings and control the servo
-  initializeTimer();
 
-  // Write the initial message on the LCD screen
-  lcdPrintLine(0, "   ControLeo2");
-  lcdPrintLine(1, "Reflow Oven v2.0");
-  delay(100);
-  playTones(TUNE_STARTUP);
-  delay(3000);
+  // Write the initial message on the LCD screen.  The main loop takes it down (see finishStartup)
+  lcdPrintLine_P(0, PSTR("   ControLeo2"));
+  lcdPrintLine_P(1, PSTR("Reflow Oven v2.0"));
+  startTone(TUNE_STARTUP);
   
-  // Initialize the EEPROM, after flashing bootloader
-  InitializeSettingsIfNeccessary();
+  // Initialize the EEPROM, after flashing bootloader.  This is done in the background
+  startSettingsInitialization();
+}
+
+
+// Called by the main loop while the splash screen is displayed
+// The splash screen is taken down after SPLASH_SCREEN_TIME (or when a button is pressed),
+// but not until the EEPROM has been initialized.  Returns true when startup is complete
+boolean finishStartup() {
+  if (!continueSettingsInitialization())
+    return false;
+  if (millis() < SPLASH_SCREEN_TIME && getButton() == CONTROLEO_BUTTON_NONE)
+    return false;
   lcd.clear();
   
   // Go straight to reflow menu if learning is complete
@@ -161,31 +191,46 @@ void setup() {
     mode = 2;
 
   Serial.println(F("ControLeo2 Reflow Oven controller v2.0"));
+  Serial.print(F("Outputs off and air thermocouple read "));
+  Serial.print(controllableTime);
+  // A faulty or disconnected thermocouple shouldn't look like a fast boot
+  if (hasReading[AIR_THERMOCOUPLE])
+    Serial.println(F("ms after reset"));
+  else
+    Serial.println(F("ms after reset, but there is no valid temperature yet"));
   
   // Make sure the oven door is closed
   setServoPosition(getSetting(SETTING_SERVO_CLOSED_DEGREES), 1000);
+  return true;
 }
 
 
 // The main menu has 4 options
 boolean (*action[NO_OF_MODES])() = {Testing, Config, Reflow, Bake};
-const char* modes[NO_OF_MODES] = {"Test Outputs?", "Setup?", "Start Reflow?", "Start Baking?"};
+const char modeTesting[] PROGMEM = "Test Outputs?";
+const char modeConfig[] PROGMEM = "Setup?";
+const char modeReflow[] PROGMEM = "Start Reflow?";
+const char modeBake[] PROGMEM = "Start Baking?";
+const char * const modes[NO_OF_MODES] PROGMEM = {modeTesting, modeConfig, modeReflow, modeBake};
 
 
 // This loop is executed 20 times per second
 void loop()
 {
+  static boolean isStarting = true;
   static boolean drawMenu = true;
   static boolean showMainMenu = true;
   static int counter = 0;
-  static unsigned long nextLoopTime = 50; // Should be 3000 + 100 + fudge factor + 50 - but no harm making it 50!
+  static unsigned long nextLoopTime = 50;
   
   
-  if (showMainMenu) {
+  if (isStarting)
+    isStarting = !finishStartup();
+  else if (showMainMenu) {
     if (drawMenu) {
       drawMenu = false;
-      lcdPrintLine(0, modes[mode]);
-      lcdPrintLine(1, "          Yes ->");
+      lcdPrintLine_P(0, getDescription(modes, mode));
+      lcdPrintLine_P(1, PSTR("          Yes ->"));
     }
     
     // Update the temperature roughtly once per second
@@ -208,53 +253,59 @@ void loop()
   }
   else {
     // Go to the mode's menu system
-    if ((*action[mode])() == NEXT_MODE)
+    if ((*action[mode])() == NEXT_MODE) {
       showMainMenu = true;
+      reportLoopIdleTime();
+    }
   }
   
+  // Start the next note of any tune that is playing
+  updateTones();
+  
   // Execute this loop 20 times per second (every 50ms). 
-  if (millis() < nextLoopTime)
-    delay(nextLoopTime - millis());
+  sleepUntil(nextLoopTime);
   nextLoopTime += 50;
 }
 
 
-// Determine if a button was pressed (with debounce)
-// A button can only be pressed once every 200ms. If a button is
-// pressed and held, a button press will be generated every 200ms.
-// Returns:
-//   CONTROLEO_BUTTON_NONE if no button are pressed
-//   CONTROLEO_BUTTON_TOP if the top button was pressed
-//   CONTROLEO_BUTTON_BOTTOM if the bottom button was pressed
-// Note: If both buttons are pressed simultaneously, CONTROLEO_BUTTON_TOP will be returned
-#define DEBOUNCE_INTERVAL  200
-
-int getButton()
-{
-  static long lastChangeMillis = 0;
-  long nowMillis = millis();
-  int buttonValue;
-  
-  // If insufficient time has passed, just return none pressed
-  if (lastChangeMillis + DEBOUNCE_INTERVAL > nowMillis)
-    return CONTROLEO_BUTTON_NONE;
+// Sleep until it is time to run the loop again
+// Idle mode stops the CPU but leaves the timers and interrupts running.  Any interrupt
+// wakes it: Timer 0 (which keeps millis() running) every 1ms, Timer 1 (thermocouples,
+// servo and buttons) every 20ms and the buttons.  Time spent in interrupts while
+// sleeping is counted as idle.
+// Any EEPROM initialization is done while waiting, so it doesn't hold up the main loop
+void sleepUntil(unsigned long wakeTime) {
+  static unsigned long periodStart = micros();   // Start measuring from the first loop, not from reset
+  static unsigned long idleMicros = 0;
+  unsigned long sleepStart = micros();
   
-  // Read the current button status
-  buttonValue = CONTROLEO_BUTTON_NONE;
-  if (digitalRead(CONTROLEO_BUTTON_TOP_PIN) == LOW) {
-    buttonValue = CONTROLEO_BUTTON_TOP;
-    playTones(TUNE_TOP_BUTTON_PRESS);
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  while ((long) (millis() - wakeTime) < 0) {
+    // Initialize the EEPROM a byte at a time while waiting (see Settings.ino)
+    continueSettingsInitialization();
+    sleep_mode();
   }
-  else if (digitalRead(CONTROLEO_BUTTON_BOTTOM_PIN) == LOW) {
-    buttonValue = CONTROLEO_BUTTON_BOTTOM;
-    playTones(TUNE_BOTTOM_BUTTON_PRESS);
-  }
-    
-  // Note the time the button was pressed
-  if (buttonValue != CONTROLEO_BUTTON_NONE)
-   lastChangeMillis = nowMillis;
   
-  return buttonValue;
+  // Work out the idle percentage once per second
+  unsigned long now = micros();
+  idleMicros += now - sleepStart;
+  if (now - periodStart >= 1000000) {
+    loopIdlePercent = min(idleMicros / ((now - periodStart) / 100), 100UL);
+    loopMinIdlePercent = min(loopMinIdlePercent, loopIdlePercent);
+    periodStart = now;
+    idleMicros = 0;
+  }
+}
+
+
+// Print how busy the main loop has been since the last report
+void reportLoopIdleTime() {
+  Serial.print(F("Main loop idle "));
+  Serial.print(loopIdlePercent);
+  Serial.print(F("% (busiest second: "));
+  Serial.print(loopMinIdlePercent);
+  Serial.println(F("% idle)"));
+  loopMinIdlePercent = 100;
 }
 
 
@@ -273,16 +324,37 @@ void lcdPrintLine(int line, const char* str) {
 }
 
 
+// Display a line stored in flash (PROGMEM) on the LCD screen
+void lcdPrintLine_P(int line, const char* str) {
+  char buffer[17];
+  // Sanity check on the parameters
+  if (!str || strlen_P(str) > 16)
+    return;
+  strcpy_P(buffer, str);
+  lcdPrintLine(line, buffer);
+}
+
+
 // Displays the temperature in the bottom left corner of the LCD display
 void displayTemperature(double temperature) {
+  char buffer[9];
   lcd.setCursor(0, 1);
   if (THERMOCOUPLE_FAULT(temperature)) {
-    lcd.print("        ");
+    lcd.print(F("        "));
     return;
   }
-  lcd.print(temperature);
-  // Print degree Celsius symbol
-  lcd.print("\1C ");  
+  // The temperature is right-aligned, so it always overwrites the previous one
+  formatTemperature(buffer, temperature, 6);
+  // Add the degree Celsius symbol
+  strcat(buffer, "\1C");
+  lcd.print(buffer);
+}
+
+
+// Format the temperature with 2 decimal places, right-aligned in the given width (0 = no padding)
+// This is much faster than printing a double.  The buffer must be at least 13 characters if width is 0
+char *formatTemperature(char *buffer, double temperature, uint8_t width) {
+  return formatNumber(buffer, (long) (temperature * 100 + (temperature < 0? -0.5 : 0.5)), width, 2);
 }
 
 
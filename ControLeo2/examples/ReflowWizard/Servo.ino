@@ -1,6 +1,8 @@
-// Timer 1 is used for 2 things:
-// 1. Take thermocouple readings every 200ms (5 times per second)
+// Timer 1 is used for 3 things:
+// 1. Take thermocouple readings every 200ms (5 times per second).  The thermocouples are read
+//    one at a time, on consecutive timer interrupts
 // 2. Control the servo used to open the oven door
+// 3. Generate the long press and repeat events for buttons that are held down (see Buttons.ino)
 //
 // Servo timer interrupt operation
 // ===============================
@@ -9,7 +11,7 @@
 // The servo position information should be sent every 20ms, or 50 times per second.  To do this:
 //   - Timer 1 is set to CTC mode
 //   - Compare A is set to a value to force a timer interrupt every 20ms
-// For every 10 times the timer fires, a call is made to get a thermocouple reading.
+// For every 10 times the timer fires, a call is made to get a reading from each thermocouple.
 // If servo movement is enabled (interrupt on Compare B, OCIE1B is set) then the servo pin
 // is set high.  It must be lowered somewhere between 1ms and 2ms later, depending on the desired
 // position.  To do this, the appropriate value is written to OCR1B.  Keep in mind that unlike
@@ -28,6 +30,8 @@
 #define MAX_PULSE_WIDTH      2400     // The longest pulse sent to a servo (from Arduino's servo library)
 
 
+extern volatile int temperatureSource;
+
 // Variables used to control servo movement
 int servoEndValue;                    // The desired pulse width
 volatile int servoMovements;          // Number of movements to reach the desired position
@@ -58,15 +62,21 @@ void initializeTimer(void) {
 // This timer fires 50 times per second (every 20ms)
 ISR(TIMER1_COMPA_vect)
 {
-  volatile static int thermocoupleTimer = 0;
+  volatile static int thermocoupleTimer = 9;   // The thermocouples are read on the first interrupt after reset
   
-  // Read the thermocouple 5 times per second (every 0.2 seconds)
-  if (++thermocoupleTimer >= 10) {
+  // Button long presses and repeats
+  updateButtons();
+
+  // Read each thermocouple 5 times per second (every 0.2 seconds)
+  if (++thermocoupleTimer >= 10)
     thermocoupleTimer = 0;
-    takeCurrentThermocoupleReading();
-    
-    // Don't move the servo - the pulse won't have the correct timing because of the time taken to read the thermocouple
-    return;
+  if (thermocoupleTimer < NUM_THERMOCOUPLES) {
+    // Only read the board thermocouple if it is being used
+    if (thermocoupleTimer == AIR_THERMOCOUPLE || temperatureSource != TEMPERATURE_SOURCE_AIR) {
+      takeCurrentThermocoupleReading(thermocoupleTimer);
+      // Don't move the servo - the pulse won't have the correct timing because of the time taken to read the thermocouple
+      return;
+    }
   }
   
   // Is the servo timer interrupt active?
@@ -96,8 +106,11 @@ ISR(TIMER1_COMPB_vect)
 
 // Move the servo to servoDegrees, in timeToTake milliseconds (1/1000 second)
 void setServoPosition(unsigned int servoDegrees, int timeToTake) {
-  sprintf(debugBuffer, "Servo: move to %d degrees, over %d ms", servoDegrees, timeToTake);
-  Serial.println(debugBuffer);
+  Serial.print(F("Servo: move to "));
+  Serial.print(servoDegrees);
+  Serial.print(F(" degrees, over "));
+  Serial.print(timeToTake);
+  Serial.println(F(" ms"));
   // Make sure the degrees are 0 - 180
   if (servoDegrees > 180)
     return;
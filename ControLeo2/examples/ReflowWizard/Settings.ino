@@ -25,6 +25,11 @@ int getSetting(int settingNum) {
   if (settingNum == SETTING_BAKE_TEMPERATURE)
     return val * BAKE_TEMPERATURE_STEP;
 
+  // The temperature source was added after version 2.0.  Before that the byte was unused (0xFF),
+  // so anything out of range is treated as the default (air temperature only)
+  if (settingNum == SETTING_TEMPERATURE_SOURCE && val >= NO_OF_TEMPERATURE_SOURCES)
+    return TEMPERATURE_SOURCE_AIR;
+
   return val;
 }
 
@@ -45,12 +50,15 @@ void setSetting(int settingNum, int value) {
       EEPROM.write(SETTING_SETTINGS_CHANGED, true);
       EEPROM.write(SETTING_LEARNING_MODE, true);
       EEPROM.write(settingNum, value);
+      // The learned bake duty cycles were for the old element configuration
+      clearLearnedBakeDutyCycles();
       Serial.println(F("Settings changed!  Duty cycles have been reset and learning mode has been enabled"));
       break;
       
     case SETTING_MAX_TEMPERATURE:
-      // Enable learning mode if the maximum temperature has changed a lot
-      if (abs(getSetting(settingNum) - value) > 5)
+      // Enable learning mode if the maximum temperature has changed a lot, unless there is
+      // a stored calibration that can be used for the new temperature
+      if (abs(getSetting(settingNum) - value) > 5 && !loadCalibration(value))
         EEPROM.write(SETTING_LEARNING_MODE, true);
       // Write the new maximum temperature
       EEPROM.write(settingNum, value - TEMPERATURE_OFFSET);
@@ -60,6 +68,17 @@ void setSetting(int settingNum, int value) {
       EEPROM.write(settingNum, value / BAKE_TEMPERATURE_STEP);
       break;
 
+    case SETTING_TEMPERATURE_SOURCE:
+      EEPROM.write(settingNum, value);
+      // Start reading the board thermocouple straight away, if it is needed
+      setTemperatureSource(value);
+      // The duty cycles depend on where the temperature is measured.  Use a stored calibration for
+      // this temperature source if there is one, otherwise relearn
+      if (!loadCalibration(getSetting(SETTING_MAX_TEMPERATURE)))
+        EEPROM.write(SETTING_LEARNING_MODE, true);
+      clearLearnedBakeDutyCycles();
+      break;
+
     default:
       EEPROM.write(settingNum, value);
       break;
@@ -67,29 +86,227 @@ void setSetting(int settingNum, int value) {
 }
 
 
-void InitializeSettingsIfNeccessary() {
+// The EEPROM is initialized in the background, so ControLeo2 is ready to use as soon as
+// it is turned on.  Writing a byte takes 3.3ms, so clearing all 1024 bytes takes over 3
+// seconds.  continueSettingsInitialization() is called each time the main loop wakes from
+// sleep, and writes a byte if the EEPROM has finished writing the previous one.
+// The bytes are cleared from the top down, so the setting that shows the EEPROM needs to
+// be initialized is cleared last.  If power is lost part way through, it starts again.
+boolean isInitializingSettings = false;
+int settingsInitNext;                 // The next byte to clear
+int settingsInitLast;                 // The last byte to clear
+
+
+// Check if the EEPROM needs to be initialized, and start initializing it
+void startSettingsInitialization() {
   // Does the EEPROM need to be initialized?
-  if (getSetting(SETTING_EEPROM_NEEDS_INIT)) {
-    // Initialize all the settings to 0 (false)
-    for (int i=0; i<1024; i++)
-      EEPROM.write(i, 0);
-    // Set a reasonable max temperature
+  if (getSetting(SETTING_EEPROM_NEEDS_INIT))
+    settingsInitLast = 0;
+  // Legacy support - Initialize the rest of EEPROM for upgrade from 1.x to 1.4
+  else if (getSetting(SETTING_SERVO_OPEN_DEGREES) > 180)
+    settingsInitLast = SETTING_SERVO_OPEN_DEGREES;
+  else
+    return;
+  settingsInitNext = 1023;
+  isInitializingSettings = true;
+}
+
+
+// Clear the next byte of EEPROM, if the EEPROM is ready
+// Returns true once the EEPROM has been initialized (or didn't need to be)
+boolean continueSettingsInitialization() {
+  if (!isInitializingSettings)
+    return true;
+  // Don't wait for the previous write to finish
+  if (!eeprom_is_ready())
+    return false;
+  // Skip bytes that are already clear (after an interrupted initialization)
+  while (settingsInitNext >= settingsInitLast && EEPROM.read(settingsInitNext) == 0)
+    settingsInitNext--;
+  if (settingsInitNext >= settingsInitLast) {
+    EEPROM.write(settingsInitNext--, 0);
+    return false;
+  }
+
+  // All the settings are 0 (false).  Now set the ones that need a different default
+  isInitializingSettings = false;
+  // Set a reasonable max temperature (the legacy settings already have one)
+  if (settingsInitLast == 0)
     setSetting(SETTING_MAX_TEMPERATURE, 240);
-    // Set the servos to neutral positions (90 degrees)
-    setSetting(SETTING_SERVO_CLOSED_DEGREES, 90);
-    setSetting(SETTING_SERVO_OPEN_DEGREES, 90);
-    // Set default baking temperature
-    setSetting(SETTING_BAKE_TEMPERATURE, BAKE_MIN_TEMPERATURE);
+  // Set the servos to neutral positions (90 degrees)
+  setSetting(SETTING_SERVO_CLOSED_DEGREES, 90);
+  setSetting(SETTING_SERVO_OPEN_DEGREES, 90);
+  // Set default baking temperature
+  setSetting(SETTING_BAKE_TEMPERATURE, BAKE_MIN_TEMPERATURE);
+  // The temperature source may have changed (after a factory reset)
+  setTemperatureSource(getSetting(SETTING_TEMPERATURE_SOURCE));
+  return true;
+}
+
+
+// Initialize the EEPROM if it needs it, and wait until it is done
+void InitializeSettingsIfNeccessary() {
+  startSettingsInitialization();
+  while (!continueSettingsInitialization())
+    ;
+}
+
+
+// The steady-state duty cycle learned during previous bakes is stored for each bake temperature.
+// If there is nothing stored for this temperature then interpolate between the nearest learned
+// temperatures on either side.
+// Returns 0 if no duty cycle can be determined
+int getLearnedBakeDutyCycle(int temperature) {
+  int index = (temperature - BAKE_MIN_TEMPERATURE) / BAKE_TEMPERATURE_STEP;
+  int lower, upper, lowerDuty = 0, upperDuty = 0;
+
+  // Sanity check on the parameter
+  if (index < 0 || index >= BAKE_DUTY_CYCLE_ENTRIES)
+    return 0;
+
+  // Has this temperature been learned?
+  if (getSetting(SETTING_BAKE_DUTY_CYCLE_TABLE + index))
+    return getSetting(SETTING_BAKE_DUTY_CYCLE_TABLE + index);
+
+  // Find the closest learned temperatures below and above this one
+  for (lower = index - 1; lower >= 0; lower--)
+    if ((lowerDuty = getSetting(SETTING_BAKE_DUTY_CYCLE_TABLE + lower)) != 0)
+      break;
+  for (upper = index + 1; upper < BAKE_DUTY_CYCLE_ENTRIES; upper++)
+    if ((upperDuty = getSetting(SETTING_BAKE_DUTY_CYCLE_TABLE + upper)) != 0)
+      break;
+
+  // Can only interpolate if there are learned values on both sides
+  if (lower < 0 || upper >= BAKE_DUTY_CYCLE_ENTRIES)
+    return 0;
+
+  return map(index, lower, upper, lowerDuty, upperDuty);
+}
+
+
+// Save the steady-state duty cycle for this bake temperature
+void setLearnedBakeDutyCycle(int temperature, int dutyCycle) {
+  int index = (temperature - BAKE_MIN_TEMPERATURE) / BAKE_TEMPERATURE_STEP;
+
+  // Sanity check on the parameters.  A duty cycle of 0 means "not learned" so don't save it
+  if (index < 0 || index >= BAKE_DUTY_CYCLE_ENTRIES || dutyCycle <= 0)
+    return;
+  setSetting(SETTING_BAKE_DUTY_CYCLE_TABLE + index, min(dutyCycle, 100));
+}
+
+
+// Forget all the learned bake duty cycles
+void clearLearnedBakeDutyCycles() {
+  for (int i=0; i<BAKE_DUTY_CYCLE_ENTRIES; i++)
+    setSetting(SETTING_BAKE_DUTY_CYCLE_TABLE + i, 0);
+}
+
+
+// The output types are packed into 16 bits (3 bits per output) so they can be stored with a calibration.
+// The temperature source is stored in the top bits, because calibrations aren't interchangeable between them.
+uint16_t getPackedOutputTypes() {
+  uint16_t types = 0;
+  for (int i=0; i<4; i++)
+    types |= getSetting(SETTING_D4_TYPE + i) << (i * 3);
+  return types | (getSetting(SETTING_TEMPERATURE_SOURCE) << 12);
+}
+
+
+// Returns true if the calibration in this slot was learned with the current output types
+boolean isCalibrationForCurrentOutputs(int slot) {
+  int address = SETTING_CALIBRATION_STORE + slot * CALIBRATION_SLOT_SIZE;
+  uint16_t types = getSetting(address + CALIBRATION_OUTPUT_TYPES) | (getSetting(address + CALIBRATION_OUTPUT_TYPES + 1) << 8);
+  return getSetting(address + CALIBRATION_MAX_TEMPERATURE) != 0 && types == getPackedOutputTypes();
+}
+
+
+// Save the current duty cycles as the calibration for this maximum temperature.  This replaces
+// a calibration for the same temperature, otherwise an empty slot is used.  If there are no empty
+// slots then the calibration with the closest maximum temperature is replaced.
+void storeCalibration(int maxTemperature) {
+  int slot, address, emptySlot = -1, closestSlot = 0, closestDifference = 1000;
+  uint16_t types = getPackedOutputTypes();
+
+  for (slot=0; slot<CALIBRATION_SLOTS; slot++) {
+    int storedTemperature = getSetting(SETTING_CALIBRATION_STORE + slot * CALIBRATION_SLOT_SIZE + CALIBRATION_MAX_TEMPERATURE);
+    // Is this slot already used for this temperature?
+    if (storedTemperature + TEMPERATURE_OFFSET == maxTemperature && isCalibrationForCurrentOutputs(slot))
+      break;
+    if (storedTemperature == 0) {
+      if (emptySlot == -1)
+        emptySlot = slot;
+    }
+    else if (abs(storedTemperature + TEMPERATURE_OFFSET - maxTemperature) < closestDifference) {
+      closestDifference = abs(storedTemperature + TEMPERATURE_OFFSET - maxTemperature);
+      closestSlot = slot;
+    }
   }
-  
-  // Legacy support - Initialize the rest of EEPROM for upgrade from 1.x to 1.4
-  if (getSetting(SETTING_SERVO_OPEN_DEGREES) > 180) {
-    for (int i=SETTING_SERVO_OPEN_DEGREES; i<1024; i++)
-      EEPROM.write(i, 0);
-    setSetting(SETTING_SERVO_CLOSED_DEGREES, 90);
-    setSetting(SETTING_SERVO_OPEN_DEGREES, 90);
-    setSetting(SETTING_BAKE_TEMPERATURE, BAKE_MIN_TEMPERATURE);
+  if (slot == CALIBRATION_SLOTS)
+    slot = (emptySlot != -1)? emptySlot : closestSlot;
+
+  Serial.print(F("Saving calibration for "));
+  Serial.print(maxTemperature);
+  Serial.print(F(" Celsius in slot "));
+  Serial.println(slot);
+  address = SETTING_CALIBRATION_STORE + slot * CALIBRATION_SLOT_SIZE;
+  setSetting(address + CALIBRATION_MAX_TEMPERATURE, maxTemperature - TEMPERATURE_OFFSET);
+  setSetting(address + CALIBRATION_OUTPUT_TYPES, types & 0xFF);
+  setSetting(address + CALIBRATION_OUTPUT_TYPES + 1, types >> 8);
+  for (int i=0; i<12; i++)
+    setSetting(address + CALIBRATION_DUTY_CYCLES + i, getSetting(SETTING_PRESOAK_D4_DUTY_CYCLE + i));
+}
+
+
+// Load the duty cycles for this maximum temperature from the stored calibrations.  A calibration
+// within 5 degrees is used as-is.  Otherwise the duty cycles are interpolated from the closest
+// calibrations below and above this temperature.
+// Returns false if no suitable calibration was found
+boolean loadCalibration(int maxTemperature) {
+  int below = -1, above = -1, closest = -1;
+  int belowTemperature = 0, aboveTemperature = 1000;
+
+  // Find the closest calibrations (for the current outputs) on either side of this temperature
+  for (int slot=0; slot<CALIBRATION_SLOTS; slot++) {
+    if (!isCalibrationForCurrentOutputs(slot))
+      continue;
+    int storedTemperature = getSetting(SETTING_CALIBRATION_STORE + slot * CALIBRATION_SLOT_SIZE + CALIBRATION_MAX_TEMPERATURE) + TEMPERATURE_OFFSET;
+    if (storedTemperature <= maxTemperature && storedTemperature > belowTemperature) {
+      below = slot;
+      belowTemperature = storedTemperature;
+    }
+    if (storedTemperature >= maxTemperature && storedTemperature < aboveTemperature) {
+      above = slot;
+      aboveTemperature = storedTemperature;
+    }
+  }
+
+  // Is either one close enough to use without interpolation?
+  if (below != -1 && maxTemperature - belowTemperature <= 5)
+    closest = below;
+  if (above != -1 && aboveTemperature - maxTemperature <= 5 && (closest == -1 || aboveTemperature - maxTemperature < maxTemperature - belowTemperature))
+    closest = above;
+  if (closest != -1) {
+    below = above = closest;
+    belowTemperature = aboveTemperature = getSetting(SETTING_CALIBRATION_STORE + closest * CALIBRATION_SLOT_SIZE + CALIBRATION_MAX_TEMPERATURE) + TEMPERATURE_OFFSET;
+  }
+  else if (below == -1 || above == -1)
+    return false;
+
+  Serial.print(F("Using calibration for "));
+  Serial.print(belowTemperature);
+  Serial.print(F(" to "));
+  Serial.print(aboveTemperature);
+  Serial.println(F(" Celsius"));
+  for (int i=0; i<12; i++) {
+    int belowDutyCycle = getSetting(SETTING_CALIBRATION_STORE + below * CALIBRATION_SLOT_SIZE + CALIBRATION_DUTY_CYCLES + i);
+    int aboveDutyCycle = getSetting(SETTING_CALIBRATION_STORE + above * CALIBRATION_SLOT_SIZE + CALIBRATION_DUTY_CYCLES + i);
+    if (below != above)
+      belowDutyCycle = map(maxTemperature, belowTemperature, aboveTemperature, belowDutyCycle, aboveDutyCycle);
+    setSetting(SETTING_PRESOAK_D4_DUTY_CYCLE + i, belowDutyCycle);
   }
+  // The calibration is for the current outputs, so there is no need to relearn
+  setSetting(SETTING_LEARNING_MODE, false);
+  return true;
 }
 
 
@@ -100,7 +317,7 @@ uint16_t getBakeSeconds(int duration)
 
   // Sanity check on the parameter
   if (duration >= BAKE_MAX_DURATION)
-    return 5;
+    return 5 * 60;
   
   // 5 to 60 minutes, at 1 minute increments
   if (duration <= 55)
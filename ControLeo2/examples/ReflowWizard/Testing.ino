@@ -14,8 +14,8 @@ boolean Testing() {
   // Is this the first time "Testing" has been run?
   if (firstRun) {
     firstRun = false;
-    lcdPrintLine(0, "Test Outputs");
-    lcdPrintLine(1, "Output 4");
+    lcdPrintLine_P(0, PSTR("Test Outputs"));
+    lcdPrintLine_P(1, PSTR("Output 4"));
     displayOnState(channelIsOn);
   }
   
@@ -61,5 +61,5 @@ boolean Testing() {
 
 void displayOnState(boolean isOn) {
   lcd.setCursor(9, 1);
-  lcd.print(isOn? "is on ": "is off");
+  lcd.print(isOn? F("is on "): F("is off"));
 }
@@ -3,62 +3,77 @@
 // Also, some convection ovens have noisy fans that generate spurious short-to-ground and 
 // short-to-vcc errors.  This will help to eliminate those.
 // takeCurrentThermocoupleReading() is called from the Timer 1 interrupt (see "Servo" tab).  It is
-// called 5 times per second.
+// called 5 times per second for each thermocouple.
+//
+// A second MAX31855 can be connected to MISO (D8) and SCK (D10), with its chip select on D12.  Its
+// thermocouple should be attached to a PCB so the oven can be controlled on the board temperature
+// instead of the air temperature.  The temperature used for control is selected in the Setup menu.
 
 #define NUM_READINGS           5   // Number of readings to average the temperature over (5 readings = 1 second)
 #define ERROR_THRESHOLD        15  // Number of consecutive faults before a fault is returned
 
 
 // Store the temperatures as they are read
-volatile float recentTemperatures[NUM_READINGS];
-volatile int temperatureErrorCount = 0;
-volatile float temperatureError;
-ControLeo2_MAX31855 thermocouple;
+volatile float recentTemperatures[NUM_THERMOCOUPLES][NUM_READINGS];
+volatile int temperatureErrorCount[NUM_THERMOCOUPLES];
+volatile float temperatureError[NUM_THERMOCOUPLES];
+volatile int temperatureSource = TEMPERATURE_SOURCE_AIR;   // Copy of the setting, so the ISR doesn't need to read EEPROM
+volatile boolean hasReading[NUM_THERMOCOUPLES];             // False until the thermocouple has been read (see takeCurrentThermocoupleReading)
+ControLeo2_MAX31855 thermocouples[NUM_THERMOCOUPLES] = {ControLeo2_MAX31855(MAX31855_DEFAULT_CS_PIN), ControLeo2_MAX31855(BOARD_THERMOCOUPLE_CS_PIN)};
 
 
-// This function is called every 200ms from the Timer 1 (servo) interrupt
-void takeCurrentThermocoupleReading()
+// This function is called every 200ms for each thermocouple from the Timer 1 (servo) interrupt
+void takeCurrentThermocoupleReading(int num)
 {
-  volatile static int readingNum = 0;
+  volatile static int readingNum[NUM_THERMOCOUPLES];
     
   // The timer has fired.  It has been 0.2 seconds since the previous reading was taken
   // Take a thermocouple reading
-  float temperature = thermocouple.readThermocouple(CELSIUS);
+  float temperature = thermocouples[num].readThermocouple(CELSIUS);
+  if (num == AIR_THERMOCOUPLE && !controllableTime)
+    controllableTime = millis();
   
   // Is there an error?
   if (THERMOCOUPLE_FAULT(temperature)) {
     // Noise can cause spurious short faults.  These are typically caused by the convection fan
-    if (temperatureErrorCount < ERROR_THRESHOLD)
-      temperatureErrorCount++;
-    temperatureError = temperature;
+    if (temperatureErrorCount[num] < ERROR_THRESHOLD)
+      temperatureErrorCount[num]++;
+    temperatureError[num] = temperature;
   }
   else {
     // There is no error.  Save the temperature
-    recentTemperatures[readingNum] = temperature;
-    readingNum = (readingNum + 1) % NUM_READINGS;
+    // The first reading (after reset, or after the board thermocouple starts being read) fills the
+    // whole average, so the temperature is right straight away
+    if (!hasReading[num]) {
+      hasReading[num] = true;
+      for (int i=0; i<NUM_READINGS; i++)
+        recentTemperatures[num][i] = temperature;
+    }
+    recentTemperatures[num][readingNum[num]] = temperature;
+    readingNum[num] = (readingNum[num] + 1) % NUM_READINGS;
     // Clear any previous error
-    temperatureErrorCount = 0;
+    temperatureErrorCount[num] = 0;
   }
 }
 
 
 
-// Routine used by the main app to get temperatures
+// Get the average temperature of one of the thermocouples
 // This routine disables and then re-enables interrupts so that data corruption isn't caused
 // by the ISR writing data at the same time it is read here.
-float getCurrentTemperature() {
+float getThermocoupleTemperature(int num) {
   float temperature = 0;
   
   // Disable interrupts while reading values
   noInterrupts();
 
   // Is there an error?
-  if (temperatureErrorCount >= ERROR_THRESHOLD)
-    temperature = temperatureError;
+  if (temperatureErrorCount[num] >= ERROR_THRESHOLD)
+    temperature = temperatureError[num];
   else {
     // Return the average of the last NUM_READINGS readings
     for (int i=0; i< NUM_READINGS; i++)
-      temperature += recentTemperatures[i];
+      temperature += recentTemperatures[num][i];
     temperature = temperature / NUM_READINGS;
   }
   
@@ -69,3 +84,45 @@ float getCurrentTemperature() {
   return temperature;
 }
 
+
+// Set the thermocouple(s) used to control the oven (one of the TEMPERATURE_SOURCE_xxx values)
+// Called at startup and whenever the setting changes, so the Timer 1 interrupt starts reading the
+// board thermocouple before its temperature is needed
+void setTemperatureSource(int source) {
+  noInterrupts();
+  // The board thermocouple's average is stale (or was never taken) if it wasn't being read
+  if (temperatureSource == TEMPERATURE_SOURCE_AIR && source != TEMPERATURE_SOURCE_AIR) {
+    hasReading[BOARD_THERMOCOUPLE] = false;
+    temperatureErrorCount[BOARD_THERMOCOUPLE] = 0;
+  }
+  temperatureSource = source;
+  interrupts();
+}
+
+
+// Routine used by the main app to get temperatures
+// The air and board temperatures are combined according to the temperature source setting.  If a
+// thermocouple that is needed has a fault then the fault is returned.
+float getCurrentTemperature() {
+  float airTemperature = getThermocoupleTemperature(AIR_THERMOCOUPLE);
+  float boardTemperature;
+  int source = temperatureSource;
+
+  // The air temperature is all that's needed when there is no board thermocouple.  It is also
+  // used for the first 200ms after the board thermocouple is selected, until it has been read
+  if (source == TEMPERATURE_SOURCE_AIR || (!hasReading[BOARD_THERMOCOUPLE] && temperatureErrorCount[BOARD_THERMOCOUPLE] < ERROR_THRESHOLD))
+    return airTemperature;
+
+  boardTemperature = getThermocoupleTemperature(BOARD_THERMOCOUPLE);
+  if (source == TEMPERATURE_SOURCE_BOARD || THERMOCOUPLE_FAULT(boardTemperature))
+    return boardTemperature;
+  if (THERMOCOUPLE_FAULT(airTemperature))
+    return airTemperature;
+
+  if (source == TEMPERATURE_SOURCE_MAX)
+    return max(airTemperature, boardTemperature);
+
+  // Weighted towards the board temperature
+  return (airTemperature * (100 - BOARD_TEMPERATURE_WEIGHT) + boardTemperature * BOARD_TEMPERATURE_WEIGHT) / 100;
+}
+
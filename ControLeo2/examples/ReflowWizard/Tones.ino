@@ -1,30 +1,83 @@
 // Play the selected tone
-// This is a synchronous (blocking) call.  The function doesn't return until the
-// tone has been played.  This works fine for this application, but it could be
-// done using a timer interrupt and a lot more (complicated) code.
+// playTones() is a synchronous (blocking) call.  The function doesn't return until the
+// tone has been played.
+// startTone() plays a tune in the background.  It starts the first note and returns,
+// and updateTones() (called from the main loop) starts each of the following notes when
+// the previous one is done.  The notes are started by the main loop so they may be up
+// to 50ms late, which is fine for button clicks and the startup tune.
 
 #include "pitches.h"
 
-const int tones[MAX_TUNES][17] = {
-      {NOTE_C5,8,NOTE_G4,8,-1},   // TUNE_STARTUP
-      {NOTE_F5,30,-1},            // TUNE_TOP_BUTTON_PRESS
-      {NOTE_B5,20,-1},            // TUNE_BOTTOM_BUTTON_PRESS
-      {NOTE_C5,4,NOTE_G4,8,NOTE_G4,8, NOTE_A4,4,NOTE_G4,4,0,4,NOTE_B4,4,NOTE_C5,4,-1}, // TUNE_REFLOW_DONE
-      {NOTE_C5,4,NOTE_B4,4,NOTE_E4,2,-1}    // TUNE_REMOVE_BOARDS
+// The tunes are stored in flash (PROGMEM) to save RAM.  Each tune is only as long as it needs to be.
+// Each note is a frequency and a duration.  The tune is terminated by a duration of 0.
+struct note {
+  uint16_t frequency;
+  uint8_t duration;
+};
+
+const struct note tuneStartup[] PROGMEM = {{NOTE_C5,8},{NOTE_G4,8},{0,0}};
+const struct note tuneTopButtonPress[] PROGMEM = {{NOTE_F5,30},{0,0}};
+const struct note tuneBottomButtonPress[] PROGMEM = {{NOTE_B5,20},{0,0}};
+const struct note tuneReflowDone[] PROGMEM = {{NOTE_C5,4},{NOTE_G4,8},{NOTE_G4,8},{NOTE_A4,4},{NOTE_G4,4},{0,4},{NOTE_B4,4},{NOTE_C5,4},{0,0}};
+const struct note tuneRemoveBoards[] PROGMEM = {{NOTE_C5,4},{NOTE_B4,4},{NOTE_E4,2},{0,0}};
+
+const struct note * const tones[MAX_TUNES] PROGMEM = {
+      tuneStartup,              // TUNE_STARTUP
+      tuneTopButtonPress,       // TUNE_TOP_BUTTON_PRESS
+      tuneBottomButtonPress,    // TUNE_BOTTOM_BUTTON_PRESS
+      tuneReflowDone,           // TUNE_REFLOW_DONE
+      tuneRemoveBoards          // TUNE_REMOVE_BOARDS
 };
 
 // Play a tone
-// Parameter: tone - an array containing alternating notes and note duration, terminated by -1
+// Parameter: tune - one of the TUNE_xxx values
 void playTones(int tune) {
   if (tune >= MAX_TUNES)
     return;
-  const int *tonesToPlay = tones[tune];
-  for (int i=0; tonesToPlay[i] != -1; i+=2) {
+  const struct note *tonesToPlay = (const struct note *) pgm_read_word(&tones[tune]);
+  uint8_t noteDuration;
+  for (int i=0; (noteDuration = pgm_read_byte(&tonesToPlay[i].duration)) != 0; i++) {
     // Note durations: 4 = quarter note, 8 = eighth note, etc.:   
-    int duration = 1000/tonesToPlay[i+1];
-    tone(CONTROLEO_BUZZER_PIN, tonesToPlay[i], duration);
-    delay(duration * 1.1);
+    int duration = 1000/noteDuration;
+    tone(CONTROLEO_BUZZER_PIN, pgm_read_word(&tonesToPlay[i].frequency), duration);
+    delay(duration * 11 / 10);
   }
   noTone(CONTROLEO_BUZZER_PIN);
 }
 
+
+
+// The tune being played in the background
+const struct note *backgroundTune = NULL;
+unsigned long nextNoteTime;
+
+
+// Start playing a tune, without waiting for it to finish
+// Parameter: tune - one of the TUNE_xxx values
+void startTone(int tune) {
+  if (tune >= MAX_TUNES)
+    return;
+  backgroundTune = (const struct note *) pgm_read_word(&tones[tune]);
+  playNextNote();
+}
+
+
+// Start the next note of the background tune when the previous one is done
+void updateTones() {
+  if (backgroundTune && (long) (millis() - nextNoteTime) >= 0)
+    playNextNote();
+}
+
+
+void playNextNote() {
+  uint8_t noteDuration = pgm_read_byte(&backgroundTune->duration);
+  if (noteDuration == 0) {
+    backgroundTune = NULL;
+    noTone(CONTROLEO_BUZZER_PIN);
+    return;
+  }
+  int duration = 1000/noteDuration;
+  tone(CONTROLEO_BUZZER_PIN, pgm_read_word(&backgroundTune->frequency), duration);
+  nextNoteTime = millis() + duration * 11 / 10;
+  backgroundTune++;
+}
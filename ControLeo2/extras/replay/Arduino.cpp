@@ -0,0 +1,177 @@
+// Minimal Arduino environment used to run ControLeo2 sketches on a PC
+// See Arduino.h
+//
+// The MAX31855 thermocouple IC is emulated at the pin level, so readings go through
+// the real ControLeo2_MAX31855 library.  MISO is D8 and SCK is D10.  Any other pin
+// can be a chip select - replayThermocoupleFrame() decides which ones have a
+// MAX31855 attached, and what it sends.
+//
+// Released under WTFPL license
+
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "avr/sleep.h"
+
+#define MISO_PIN                8
+#define CLK_PIN                 10
+#define TIMER_INTERVAL          20000UL   // Timer 1 fires every 20ms
+
+volatile uint8_t TCCR1A, TCCR1B, TIMSK1, PCICR, PCMSK0;
+volatile uint16_t TCNT1, OCR1A, OCR1B;
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+uint8_t replayPinLevel[NUM_PINS];
+ReplayPinStats replayPinStats;
+
+static unsigned long long nowMicros = 0;
+static unsigned long long nextTimerMicros = TIMER_INTERVAL;
+static boolean inInterrupt = false;
+
+// MAX31855 emulation
+static int selectedThermocouple = -1;   // The chip select pin that is low
+static uint32_t thermocoupleFrame;      // The 32 bits being shifted out
+static int thermocoupleBit;             // The bit currently on MISO
+
+
+// Encode a temperature the way the MAX31855 does
+uint32_t replayEncodeThermocoupleFrame(double temperature)
+{
+    // No thermocouple means an open circuit fault
+    if (isnan(temperature))
+        return 0x00010001;
+    // Thermocouple temperature is in bits 31-18 (0.25C resolution), cold junction in bits 15-4 (0.0625C)
+    int32_t tc = (int32_t) lround(temperature * 4);
+    int32_t junction = 25 * 16;
+    return ((uint32_t) (tc & 0x3FFF) << 18) | ((uint32_t) (junction & 0xFFF) << 4);
+}
+
+
+void replayAdvanceMicros(unsigned long us)
+{
+    unsigned long long end = nowMicros + us;
+
+    // Call the timer interrupt at every 20ms boundary along the way
+    while (!inInterrupt && nextTimerMicros <= end) {
+        nowMicros = nextTimerMicros;
+        nextTimerMicros += TIMER_INTERVAL;
+        if (TIMSK1 & _BV(OCIE1A)) {
+            inInterrupt = true;
+            TIMER1_COMPA_vect();
+            inInterrupt = false;
+        }
+    }
+    nowMicros = end;
+}
+
+
+unsigned long millis(void) { return (unsigned long) (nowMicros / 1000); }
+unsigned long micros(void) { return (unsigned long) nowMicros; }
+void delay(unsigned long ms) { replayPinStats.delayMicros += ms * 1000; replayAdvanceMicros(ms * 1000); }
+void delayMicroseconds(unsigned int us) { replayPinStats.delayMicros += us; replayAdvanceMicros(us); }
+void sleep_mode(void) { replayAdvanceMicros(1000 - nowMicros % 1000); }
+void tone(uint8_t, unsigned int, unsigned long) {}
+void noTone(uint8_t) {}
+void pinMode(uint8_t, uint8_t) {}
+void attachInterrupt(uint8_t, void (*)(void), int) {}
+void analogWrite(uint8_t pin, int value) { digitalWrite(pin, value? HIGH : LOW); }
+
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin >= NUM_PINS)
+        return;
+    value = value? HIGH : LOW;
+    replayPinStats.writes++;
+
+    if (pin == CLK_PIN) {
+        // The MAX31855 moves to the next bit on the falling edge of the clock
+        if (replayPinLevel[pin] == HIGH && value == LOW && selectedThermocouple != -1)
+            thermocoupleBit--;
+    }
+    else if (pin != MISO_PIN) {
+        // Chip select going low starts a new conversion frame
+        // Only pins with a MAX31855 respond
+        if (value == LOW && replayPinLevel[pin] == HIGH && selectedThermocouple == -1 && replayThermocoupleFrame(pin, &thermocoupleFrame)) {
+            selectedThermocouple = pin;
+            thermocoupleBit = 31;
+        }
+        if (value == HIGH && pin == selectedThermocouple)
+            selectedThermocouple = -1;
+    }
+
+    if (replayPinLevel[pin] != value) {
+        replayPinStats.toggles++;
+        replayPinChanged(pin, value);
+        replayPinLevel[pin] = value;
+    }
+}
+
+
+int digitalRead(uint8_t pin)
+{
+    replayPinStats.reads++;
+    if (pin == MISO_PIN) {
+        if (selectedThermocouple == -1 || thermocoupleBit < 0)
+            return LOW;
+        return (thermocoupleFrame >> thermocoupleBit) & 1;
+    }
+    // Buttons are never pressed (they have pull-ups)
+    return HIGH;
+}
+
+
+// ***** Print *****
+
+size_t Print::write(const char *str)
+{
+    size_t n = 0;
+    while (*str)
+        n += write((uint8_t) *str++);
+    return n;
+}
+
+size_t Print::print(const __FlashStringHelper *str) { return write((const char *) str); }
+size_t Print::print(const char *str) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t) c); }
+size_t Print::print(int value, int base) { return print((long) value, base); }
+size_t Print::print(unsigned int value, int base) { return print((unsigned long) value, base); }
+size_t Print::println(void) { return write("\r\n"); }
+
+size_t Print::print(long value, int base)
+{
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), base == 16? "%lx" : "%ld", value);
+    return write(buffer);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), base == 16? "%lx" : "%lu", value);
+    return write(buffer);
+}
+
+size_t Print::print(double value, int digits)
+{
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+
+// Collect characters into lines and pass each complete line to the replay driver
+size_t HardwareSerial::write(uint8_t c)
+{
+    static char line[256];
+    static size_t length = 0;
+
+    if (c == '\n') {
+        line[length] = 0;
+        length = 0;
+        replaySerialLine(line);
+    }
+    else if (c != '\r' && length < sizeof(line) - 1)
+        line[length++] = c;
+    return 1;
+}
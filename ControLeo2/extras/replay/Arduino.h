@@ -0,0 +1,126 @@
+// Minimal Arduino environment used to run ControLeo2 sketches on a PC
+// Time is simulated: millis() only advances when the sketch calls delay(),
+// delayMicroseconds() or sleep_mode() (which sleeps to the next 1ms Timer 0 tick),
+// or when the replay driver moves to the next loop.  The Timer 1 interrupt is
+// called every 20ms of simulated time.
+//
+// Released under WTFPL license
+
+#ifndef REPLAY_ARDUINO_H
+#define REPLAY_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH             1
+#define LOW              0
+#define INPUT            0
+#define OUTPUT           1
+#define INPUT_PULLUP     2
+
+#define A0               18
+#define A1               19
+#define A2               20
+#define A3               21
+#define A4               22
+#define A5               23
+#define NUM_PINS         24
+
+// Program memory is ordinary memory on a PC
+#define PROGMEM
+#define PSTR(s)                 (s)
+#define F(s)                    ((const __FlashStringHelper *) (s))
+template<typename T> inline T pgm_read(const T *p) { return *p; }
+#define pgm_read_byte(p)        pgm_read(p)
+#define pgm_read_word(p)        pgm_read(p)
+#define pgm_read_dword(p)       pgm_read(p)
+#define strlen_P                strlen
+#define strcpy_P                strcpy
+#define strncpy_P               strncpy
+#define memcpy_P                memcpy
+
+// Interrupts and registers
+#define ISR(vector)             void vector(void)
+#define cli()
+#define sei()
+#define noInterrupts()
+#define interrupts()
+#define _BV(bit)                (1 << (bit))
+#define WGM12                   3
+#define CS11                    1
+#define OCIE1A                  1
+#define OCIE1B                  2
+#define PCINT7                  7
+#define PCIE0                   0
+#define CHANGE                  1
+#define digitalPinToInterrupt(p) ((p) == 2? 1 : ((p) == 3? 0 : -1))
+extern volatile uint8_t TCCR1A, TCCR1B, TIMSK1, PCICR, PCMSK0;
+extern volatile uint16_t TCNT1, OCR1A, OCR1B;
+void TIMER1_COMPA_vect(void);
+void TIMER1_COMPB_vect(void);
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode);
+
+// Math
+template<typename A, typename B> inline A min(A a, B b) { return a < b? a : (A) b; }
+template<typename A, typename B> inline A max(A a, B b) { return a > b? a : (A) b; }
+#define constrain(x, low, high) ((x) < (low)? (low) : ((x) > (high)? (high) : (x)))
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) { return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin; }
+
+// I/O and time
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+#include "Print.h"
+
+class HardwareSerial : public Print {
+public:
+    void begin(long) {}
+    virtual size_t write(uint8_t c);
+};
+extern HardwareSerial Serial;
+
+
+// ***** Hooks used by the replay driver *****
+
+// Called when the chip select for csPin goes low, to get the 32-bit frame the MAX31855
+// on that pin should shift out.  Return false if there is no MAX31855 on this pin.
+extern boolean replayThermocoupleFrame(uint8_t csPin, uint32_t *frame);
+// Called with each complete line written to Serial
+extern void replaySerialLine(const char *line);
+// Called whenever an output pin changes state
+extern void replayPinChanged(uint8_t pin, uint8_t value);
+
+// Encode a temperature (Celsius) the way the MAX31855 does, with the cold junction at 25C.
+// NAN gives an open circuit fault
+uint32_t replayEncodeThermocoupleFrame(double temperature);
+
+// Pin activity, for measuring the cost of the low-level drivers.  Clear it before
+// the code being measured
+struct ReplayPinStats {
+    unsigned long writes;               // Calls to digitalWrite()
+    unsigned long reads;                // Calls to digitalRead()
+    unsigned long toggles;              // Writes that changed the level of the pin
+    unsigned long delayMicros;          // Time spent in delay() and delayMicroseconds()
+};
+extern ReplayPinStats replayPinStats;
+
+// Advance simulated time, calling the Timer 1 interrupt every 20ms
+void replayAdvanceMicros(unsigned long us);
+// Level of each pin, as last written by the sketch
+extern uint8_t replayPinLevel[NUM_PINS];
+
+#endif // REPLAY_ARDUINO_H
@@ -0,0 +1,25 @@
+// Simulated EEPROM used to run ControLeo2 sketches on a PC
+//
+// Released under WTFPL license
+
+#ifndef REPLAY_EEPROM_H
+#define REPLAY_EEPROM_H
+
+#include <stdint.h>
+
+#define EEPROM_SIZE 1024
+
+struct EEPROMClass {
+    uint8_t data[EEPROM_SIZE];
+    unsigned long writes;
+
+    uint8_t read(int address) { return data[address]; }
+    void write(int address, uint8_t value) { data[address] = value; writes++; }
+    void update(int address, uint8_t value) { if (data[address] != value) write(address, value); }
+};
+extern EEPROMClass EEPROM;
+
+// Writes are instant, so the EEPROM is always ready for the next one
+#define eeprom_is_ready()   true
+
+#endif // REPLAY_EEPROM_H
@@ -0,0 +1,31 @@
+// Minimal Arduino Print class used to run ControLeo2 sketches on a PC
+//
+// Released under WTFPL license
+
+#ifndef REPLAY_PRINT_H
+#define REPLAY_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class __FlashStringHelper;
+
+class Print {
+public:
+    virtual size_t write(uint8_t) = 0;
+    size_t write(const char *str);
+
+    size_t print(const __FlashStringHelper *str);
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(int value, int base = 10);
+    size_t print(unsigned int value, int base = 10);
+    size_t print(long value, int base = 10);
+    size_t print(unsigned long value, int base = 10);
+    size_t print(double value, int digits = 2);
+
+    size_t println(void);
+    template<typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+};
+
+#endif // REPLAY_PRINT_H
@@ -0,0 +1,18 @@
+// The Reflow Wizard sketch, compiled for a PC
+// The sketch files are compiled in the same order as the Arduino IDE: the main sketch
+// first, then the rest in alphabetical order.
+//
+// Released under WTFPL license
+
+#include "Sketch.h"
+
+#include "../../examples/ReflowWizard/ReflowWizard.ino"
+#include "../../examples/ReflowWizard/Bake.ino"
+#include "../../examples/ReflowWizard/Buttons.ino"
+#include "../../examples/ReflowWizard/Config.ino"
+#include "../../examples/ReflowWizard/Reflow.ino"
+#include "../../examples/ReflowWizard/Servo.ino"
+#include "../../examples/ReflowWizard/Settings.ino"
+#include "../../examples/ReflowWizard/Testing.ino"
+#include "../../examples/ReflowWizard/Thermocouple.ino"
+#include "../../examples/ReflowWizard/Tones.ino"
@@ -0,0 +1,75 @@
+// The Reflow Wizard sketch, compiled for a PC
+// The Arduino IDE generates function prototypes for sketches.  These need to be kept
+// up to date with the functions in the sketch.
+//
+// Released under WTFPL license
+
+#ifndef REPLAY_SKETCH_H
+#define REPLAY_SKETCH_H
+
+#include <ControLeo2.h>
+#include "../../examples/ReflowWizard/ReflowWizard.h"
+
+void setup();
+void loop();
+void sleepUntil(unsigned long wakeTime);
+void reportLoopIdleTime();
+boolean finishStartup();
+void lcdPrintLine(int line, const char* str);
+void lcdPrintLine_P(int line, const char* str);
+void displayTemperature(double temperature);
+char *formatTemperature(char *buffer, double temperature, uint8_t width);
+boolean Bake();
+void initializeButtons();
+void bottomButtonChanged();
+void queueButtonEvent(int index, uint8_t type, unsigned long now);
+void buttonChanged(int index);
+void updateButtons();
+boolean getButtonEvent(struct buttonEvent *event);
+int getButton();
+int getButtonWithStep(int smallStep, int bigStep, int *step);
+void DisplayBakeTime(uint16_t duration, double temperature, int duty, int integral);
+boolean Config();
+void displayMaxTemperature(int maxTemperature);
+void displayBakeTemperature(int bakeTemperature);
+void displayServoDegrees(int degrees);
+void displayDuration(int offset, uint16_t duration);
+boolean Reflow();
+void adjustPhaseDutyCycle(int phase, int adjustment);
+void lcdPrintPhaseMessage(int phase, const char* str);
+void loadReflowPhase(uint8_t enginePhase, struct ReflowEnginePhase *data);
+uint8_t getReflowOutputLevel(uint8_t output, uint8_t level, double temperature);
+void startReflowPhase(int phase);
+boolean reflowTooFast(int phase, unsigned long phaseTime, boolean learningMode);
+boolean reflowTooSlow(int phase, double currentTemperature, boolean learningMode);
+void serialDisplayPhaseData(int phase, const struct ReflowEnginePhase *pd);
+void displayReflowTemperature(unsigned long currentTime, unsigned long startTime, unsigned long phaseTime, double temperature);
+void displayAdjustmentsMadeContinue(boolean willContinue);
+void initializeTimer(void);
+void setServoPosition(unsigned int servoDegrees, int timeToTake);
+unsigned int degreesToTimerCounter(unsigned int servoDegrees);
+int getSetting(int settingNum);
+void setSetting(int settingNum, int value);
+void startSettingsInitialization();
+boolean continueSettingsInitialization();
+void InitializeSettingsIfNeccessary();
+int getLearnedBakeDutyCycle(int temperature);
+void setLearnedBakeDutyCycle(int temperature, int dutyCycle);
+void clearLearnedBakeDutyCycles();
+uint16_t getPackedOutputTypes();
+boolean isCalibrationForCurrentOutputs(int slot);
+void storeCalibration(int maxTemperature);
+boolean loadCalibration(int maxTemperature);
+uint16_t getBakeSeconds(int duration);
+boolean Testing();
+void displayOnState(boolean isOn);
+void takeCurrentThermocoupleReading(int num);
+float getThermocoupleTemperature(int num);
+void setTemperatureSource(int source);
+float getCurrentTemperature();
+void playTones(int tune);
+void startTone(int tune);
+void updateTones();
+void playNextNote();
+
+#endif // REPLAY_SKETCH_H
@@ -0,0 +1,2 @@
+// Program memory is ordinary memory on a PC (see Arduino.h)
+#include "../Arduino.h"
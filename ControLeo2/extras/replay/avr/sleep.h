@@ -0,0 +1,13 @@
+// Sleeping on a PC (see Arduino.h)
+#ifndef REPLAY_AVR_SLEEP_H
+#define REPLAY_AVR_SLEEP_H
+
+#include "../Arduino.h"
+
+#define SLEEP_MODE_IDLE         0
+
+inline void set_sleep_mode(uint8_t) {}
+// Sleep until the next interrupt.  Timer 0 (millis()) interrupts every 1ms
+void sleep_mode(void);
+
+#endif  // REPLAY_AVR_SLEEP_H
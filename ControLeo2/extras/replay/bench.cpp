@@ -0,0 +1,284 @@
+// Driver check and benchmark
+//
+// Runs the bit-level code in the ControLeo2 library and the Reflow Wizard on a PC, and
+// shows what it decodes and what it costs:
+// - MAX31855: frames from the datasheet (including negative temperatures and faults)
+//   are shifted in through the emulated MISO/SCK pins and decoded by readThermocouple()
+//   and readJunction()
+// - LCD: the nibbles written to the display are captured on the falling edge of the
+//   enable pin and turned back into commands and characters
+// - Settings: the encodings used to fit settings into one byte of EEPROM
+//
+// Each line shows the result, the expected result and the pin activity for one call
+// (digitalWrite() and digitalRead() calls, pin level changes and time spent in delays).
+// Use it before and after changing readData(), write4bits() and friends, to check they
+// still decode the same and to see what the change saved.  See README for building.
+//
+// Released under WTFPL license
+
+#include <EEPROM.h>
+#include "Sketch.h"
+
+#define LCD_RS_PIN              A0
+#define LCD_ENABLE_PIN          A1
+#define LCD_D4_PIN              A2
+
+static boolean verbose = false;
+static int mismatches = 0;
+
+// The frame the MAX31855 will send next
+static uint32_t benchFrame;
+
+// Data captured from the LCD
+static uint8_t lcdBytes[64];
+static uint8_t lcdIsData[64];
+static int lcdByteCount;
+static int lcdNibbleCount;
+
+
+boolean replayThermocoupleFrame(uint8_t csPin, uint32_t *frame) {
+  if (csPin != MAX31855_DEFAULT_CS_PIN)
+    return false;
+  *frame = benchFrame;
+  return true;
+}
+
+
+void replaySerialLine(const char *line) {
+  if (verbose)
+    printf("          %s\n", line);
+}
+
+
+// The LCD reads the data pins when enable goes low.  This is called before the pin changes
+void replayPinChanged(uint8_t pin, uint8_t value) {
+  if (pin != LCD_ENABLE_PIN || value != LOW || lcdByteCount == sizeof(lcdBytes))
+    return;
+  uint8_t nibble = 0;
+  for (int i=0; i<4; i++)
+    nibble |= replayPinLevel[LCD_D4_PIN + i] << i;
+  // The high nibble is sent first
+  if (lcdNibbleCount++ % 2 == 0)
+    lcdBytes[lcdByteCount] = nibble << 4;
+  else {
+    lcdBytes[lcdByteCount] |= nibble;
+    lcdIsData[lcdByteCount++] = replayPinLevel[LCD_RS_PIN];
+  }
+}
+
+
+static void startMeasurement() {
+  memset(&replayPinStats, 0, sizeof(replayPinStats));
+  lcdByteCount = lcdNibbleCount = 0;
+}
+
+
+static void printResult(const char *name, const char *result, const char *expected) {
+  boolean isDifferent = strcmp(result, expected) != 0;
+  printf("%-40s %-16s %-16s %6lu %6lu %7lu %8lu%s\n", name, result, expected, replayPinStats.writes,
+         replayPinStats.reads, replayPinStats.toggles, replayPinStats.delayMicros, isDifferent? "   <<<" : "");
+  mismatches += isDifferent;
+}
+
+
+static void printHeading(const char *heading) {
+  printf("\n%-40s %-16s %-16s %6s %6s %7s %8s\n", heading, "Result", "Expected", "Writes", "Reads", "Toggles", "Delay us");
+}
+
+
+// ***** MAX31855 *****
+
+struct Frame {
+  const char *name;
+  uint16_t thermocouple;                // 14 bits, 0.25C per bit, two's complement
+  uint16_t junction;                    // 12 bits, 0.0625C per bit, two's complement
+  uint8_t fault;                        // Fault bits (SCV, SCG, OC)
+  double expectedThermocouple;
+  double expectedJunction;
+};
+
+// From the temperature data format tables in the MAX31855 datasheet
+static const Frame frames[] = {
+  {"+1600.00 / +127.0000", 0x1900, 0x7F0, 0, 1600.00, 127.0000},
+  {"+1000.00 / +100.5625", 0x0FA0, 0x649, 0, 1000.00, 100.5625},
+  {"+100.75 / +25.0000",   0x0193, 0x190, 0, 100.75, 25.0000},
+  {"+25.00 / 0.0000",      0x0064, 0x000, 0, 25.00, 0.0000},
+  {"0.00 / -0.0625",       0x0000, 0xFFF, 0, 0.00, -0.0625},
+  {"-0.25 / -1.0000",      0x3FFF, 0xFF0, 0, -0.25, -1.0000},
+  {"-1.00 / -20.0000",     0x3FFC, 0xEC0, 0, -1.00, -20.0000},
+  {"-250.00 / -55.0000",   0x3C18, 0xC90, 0, -250.00, -55.0000},
+  {"Open circuit",         0x0000, 0x190, 1, FAULT_OPEN, 25.0000},
+  {"Short to GND",         0x0000, 0x190, 2, FAULT_SHORT_GND, 25.0000},
+  {"Short to VCC",         0x0000, 0x190, 4, FAULT_SHORT_VCC, 25.0000},
+};
+
+
+static void benchThermocouple() {
+  ControLeo2_MAX31855 thermocouple;
+  char result[20], expected[20], name[40];
+
+  printHeading("MAX31855 (thermocouple)");
+  for (size_t i=0; i<sizeof(frames) / sizeof(frames[0]); i++) {
+    const Frame &f = frames[i];
+    benchFrame = ((uint32_t) f.thermocouple << 18) | ((uint32_t) f.junction << 4) | (f.fault? 0x00010000 | f.fault : 0);
+
+    startMeasurement();
+    snprintf(result, sizeof(result), "%.4f", thermocouple.readThermocouple(CELSIUS));
+    snprintf(expected, sizeof(expected), "%.4f", f.expectedThermocouple);
+    snprintf(name, sizeof(name), "readThermocouple %s", f.name);
+    printResult(name, result, expected);
+
+    startMeasurement();
+    snprintf(result, sizeof(result), "%.4f", thermocouple.readJunction(CELSIUS));
+    snprintf(expected, sizeof(expected), "%.4f", f.expectedJunction);
+    snprintf(name, sizeof(name), "readJunction %s", f.name);
+    printResult(name, result, expected);
+  }
+
+  // Fahrenheit conversion
+  benchFrame = ((uint32_t) 0x0190 << 18) | ((uint32_t) 0x640 << 4);
+  startMeasurement();
+  snprintf(result, sizeof(result), "%.4f", thermocouple.readThermocouple(FAHRENHEIT));
+  printResult("readThermocouple 100C in F", result, "212.0000");
+  startMeasurement();
+  snprintf(result, sizeof(result), "%.4f", thermocouple.readJunction(FAHRENHEIT));
+  printResult("readJunction 100C in F", result, "212.0000");
+}
+
+
+// ***** LCD *****
+
+// Describe the bytes sent to the LCD: commands in hex, characters as they are
+static void describeLcdBytes(char *buffer, size_t size) {
+  size_t length = 0;
+  buffer[0] = 0;
+  for (int i=0; i<lcdByteCount && length < size; i++) {
+    if (lcdIsData[i])
+      length += snprintf(buffer + length, size - length, "%c", lcdBytes[i]);
+    else
+      length += snprintf(buffer + length, size - length, "%s%02X", length? " " : "", lcdBytes[i]);
+  }
+}
+
+
+static void benchLcd() {
+  ControLeo2_LiquidCrystal lcd;
+  char result[20], name[40];
+
+  printHeading("LCD (commands, in hex)");
+
+  // The initialization sequence starts with single nibbles, so only the cost is shown
+  startMeasurement();
+  lcd.begin(16, 2);
+  printResult("begin(16, 2)", "-", "-");
+
+  startMeasurement();
+  lcd.write('A');
+  describeLcdBytes(result, sizeof(result));
+  printResult("write('A')", result, "A");
+
+  startMeasurement();
+  lcd.print("0123456789ABCDEF");
+  describeLcdBytes(result, sizeof(result));
+  printResult("print(16 characters)", result, "0123456789ABCDEF");
+
+  startMeasurement();
+  lcd.clear();
+  describeLcdBytes(result, sizeof(result));
+  printResult("clear()", result, "01");
+
+  startMeasurement();
+  lcd.home();
+  describeLcdBytes(result, sizeof(result));
+  printResult("home()", result, "02");
+
+  // Rows past the bottom of the display are put on the last row
+  static const struct { uint8_t col, row; const char *expected; } cursors[] = {
+    {0, 0, "80"}, {15, 0, "8F"}, {0, 1, "C0"}, {15, 1, "CF"}, {0, 2, "C0"}, {5, 3, "C5"},
+  };
+  for (size_t i=0; i<sizeof(cursors) / sizeof(cursors[0]); i++) {
+    startMeasurement();
+    lcd.setCursor(cursors[i].col, cursors[i].row);
+    describeLcdBytes(result, sizeof(result));
+    snprintf(name, sizeof(name), "setCursor(%d, %d)", cursors[i].col, cursors[i].row);
+    printResult(name, result, cursors[i].expected);
+  }
+}
+
+
+// ***** Settings *****
+
+static void benchSettings() {
+  char result[20], expected[20], name[40];
+  int i, count;
+
+  printHeading("Settings");
+
+  // Bake durations: 5-60 minutes in 1 minute steps, then 5 minute steps to 4 hours,
+  // then 10 minute steps to 18 hours
+  static const struct { int duration; uint16_t seconds; } bakeDurations[] = {
+    {0, 300}, {55, 3600}, {56, 3900}, {91, 14400}, {92, 15000}, {BAKE_MAX_DURATION - 1, 64800}, {BAKE_MAX_DURATION, 300},
+  };
+  for (i=0; i < (int) (sizeof(bakeDurations) / sizeof(bakeDurations[0])); i++) {
+    startMeasurement();
+    snprintf(result, sizeof(result), "%u", getBakeSeconds(bakeDurations[i].duration));
+    snprintf(expected, sizeof(expected), "%u", bakeDurations[i].seconds);
+    snprintf(name, sizeof(name), "getBakeSeconds(%d)", bakeDurations[i].duration);
+    printResult(name, result, expected);
+  }
+
+  // The durations must keep increasing, so the bake duration setting can step through them
+  for (i=1, count=0; i<BAKE_MAX_DURATION; i++)
+    count += getBakeSeconds(i) <= getBakeSeconds(i - 1);
+  snprintf(result, sizeof(result), "%d", count);
+  printResult("getBakeSeconds out of order", result, "0");
+
+  // Settings stored with an offset or a step must read back the same
+  for (i=TEMPERATURE_OFFSET, count=0; i<=TEMPERATURE_OFFSET + 255; i++) {
+    setSetting(SETTING_MAX_TEMPERATURE, i);
+    count += getSetting(SETTING_MAX_TEMPERATURE) != i;
+  }
+  snprintf(result, sizeof(result), "%d", count);
+  snprintf(name, sizeof(name), "Max temperature %d-%d", TEMPERATURE_OFFSET, TEMPERATURE_OFFSET + 255);
+  printResult(name, result, "0");
+
+  for (i=BAKE_MIN_TEMPERATURE, count=0; i<=BAKE_MAX_TEMPERATURE; i += BAKE_TEMPERATURE_STEP) {
+    setSetting(SETTING_BAKE_TEMPERATURE, i);
+    count += getSetting(SETTING_BAKE_TEMPERATURE) != i;
+  }
+  snprintf(result, sizeof(result), "%d", count);
+  snprintf(name, sizeof(name), "Bake temperature %d-%d", BAKE_MIN_TEMPERATURE, BAKE_MAX_TEMPERATURE);
+  printResult(name, result, "0");
+
+  // Saving a setting that hasn't changed must not write to the EEPROM
+  EEPROM.writes = 0;
+  startMeasurement();
+  setSetting(SETTING_BAKE_TEMPERATURE, getSetting(SETTING_BAKE_TEMPERATURE));
+  setSetting(SETTING_MAX_TEMPERATURE, getSetting(SETTING_MAX_TEMPERATURE));
+  setSetting(SETTING_D4_TYPE, getSetting(SETTING_D4_TYPE));
+  snprintf(result, sizeof(result), "%lu", (unsigned long) EEPROM.writes);
+  printResult("EEPROM writes, unchanged", result, "0");
+}
+
+
+int main(int argc, char *argv[]) {
+  for (int i=1; i<argc; i++) {
+    if (!strcmp(argv[i], "-v"))
+      verbose = true;
+    else {
+      fprintf(stderr, "Usage: bench [-v]\n  -v    Print the serial output from the sketch\n");
+      return 2;
+    }
+  }
+
+  // Start with an erased EEPROM, and let the sketch initialize it
+  memset(EEPROM.data, 0xFF, sizeof(EEPROM.data));
+  InitializeSettingsIfNeccessary();
+
+  benchThermocouple();
+  benchLcd();
+  benchSettings();
+
+  printf("\n%d mismatch%s\n", mismatches, mismatches == 1? "" : "es");
+  return mismatches? 1 : 0;
+}
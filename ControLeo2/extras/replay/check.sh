@@ -0,0 +1,53 @@
+#!/bin/sh
+# Build the replay and bench tools, then check that the logs in the logs folder still replay
+# the same way and that the drivers still decode the same.
+#
+# Usage: check.sh [-u]
+#   -u    Update the expected output (after a change that is meant to alter the replay)
+#
+# The exit code is 0 if everything matches.  Needs a C++11 compiler (set CXX to choose one)
+#
+# Released under WTFPL license
+
+cd "$(dirname "$0")" || exit 2
+CXX=${CXX:-g++}
+SOURCES="Sketch.cpp Arduino.cpp ../../ControLeo2_LiquidCrystal.cpp ../../ControLeo2_MAX31855.cpp ../../ControLeo2_Format.cpp ../../ControLeo2_ReflowEngine.cpp"
+BUILD=$(mktemp -d)
+trap 'rm -rf "$BUILD"' EXIT
+UPDATE=0
+[ "$1" = "-u" ] && UPDATE=1
+
+$CXX -I. -I../.. -o "$BUILD/replay" replay.cpp $SOURCES || exit 2
+$CXX -I. -I../.. -o "$BUILD/bench" bench.cpp $SOURCES || exit 2
+
+FAILED=0
+
+# Replay a log and compare the serial output and event list with logs/<name>.expected
+# Parameters: name, then the replay options
+check() {
+  NAME=$1
+  shift
+  "$BUILD/replay" -v "$@" "logs/$NAME.log" > "$BUILD/$NAME.out"
+  if [ $UPDATE = 1 ]; then
+    cp "$BUILD/$NAME.out" "logs/$NAME.expected"
+    echo "$NAME: updated"
+  elif diff -u "logs/$NAME.expected" "$BUILD/$NAME.out"; then
+    echo "$NAME: ok"
+  else
+    echo "$NAME: CHANGED"
+    FAILED=1
+  fi
+}
+
+check reflow -m 240
+check bake -o BTCU
+
+if "$BUILD/bench" > "$BUILD/bench.out"; then
+  echo "bench: ok"
+else
+  grep "<<<" "$BUILD/bench.out"
+  echo "bench: MISMATCH"
+  FAILED=1
+fi
+
+exit $FAILED
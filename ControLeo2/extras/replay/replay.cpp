@@ -0,0 +1,446 @@
+// Reflow Wizard log replay
+//
+// Feeds the temperatures recorded in a Reflow Wizard serial log into the real Reflow() or
+// Bake() code, running on a PC with simulated time.  It reports the phase transitions,
+// learning adjustments and output duty cycles the current code would have produced, and
+// compares them to the ones in the original log.  This makes it possible to check a
+// change to the reflow or bake logic against recorded runs before it is used in an oven.
+//
+// The replay is open loop: the temperature follows the recording regardless of what the
+// outputs do.  Differences are most meaningful up to the first point where the replayed
+// code would have switched the elements differently from the original.
+//
+// The oven configuration (output types, duty cycles, maximum temperature, learning mode,
+// bake temperature and duration) is read from the log.  It can be overridden with an
+// EEPROM image or on the command line.  See README for usage.
+//
+// Released under WTFPL license
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <EEPROM.h>
+#include "Sketch.h"
+
+// ***** Log parsing *****
+
+#define REPLAY_TIMEOUT          120     // Seconds to keep running after the end of the recording
+#define REPLAY_EXTRAPOLATION    5       // Seconds to continue the trend at the end of the recording
+#define OUTPUT_TYPE_LETTERS     "UTBXCF"  // In the same order as TYPE_UNUSED ... TYPE_COOLING_FAN
+
+struct Sample {
+  double time;                          // Seconds since the start of the reflow or bake
+  double temperature;
+};
+
+struct Event {
+  int time;                             // Seconds since the start of the reflow or bake
+  std::string text;
+};
+
+// The interesting parts of a log
+struct Run {
+  boolean isBake;
+  std::vector<Sample> trace;
+  std::vector<Event> events;
+  std::vector<std::string> lines;
+  int lastTime;
+  int lastDuty;
+};
+
+
+static boolean startsWith(const std::string &str, const char *prefix) {
+  return str.compare(0, strlen(prefix), prefix) == 0;
+}
+
+
+// Returns true if the line is a temperature sample, like "12, 3, 45.25" (reflow) or "3600, 25, 4, 45.25" (bake)
+static boolean parseSample(const std::string &line, std::vector<double> &fields) {
+  const char *p = line.c_str();
+  char *end;
+  fields.clear();
+  while (*p) {
+    double value = strtod(p, &end);
+    if (end == p)
+      return false;
+    fields.push_back(value);
+    p = end;
+    while (*p == ' ')
+      p++;
+    if (*p == ',')
+      p++;
+    else if (*p)
+      return false;
+    while (*p == ' ')
+      p++;
+  }
+  return fields.size() == 3 || fields.size() == 4;
+}
+
+
+// Add a line of serial output to the run, recording samples and events
+static void addLine(Run &run, const std::string &line) {
+  std::vector<double> fields;
+
+  run.lines.push_back(line);
+  if (parseSample(line, fields)) {
+    if (fields.size() == 4) {
+      // Bake samples are one second apart.  Log changes to the duty cycle
+      run.isBake = true;
+      run.lastTime = run.trace.size();
+      if ((int) fields[1] != run.lastDuty) {
+        run.events.push_back(Event{run.lastTime, "Bake duty cycle " + std::to_string((int) fields[1])});
+        run.lastDuty = (int) fields[1];
+      }
+    }
+    else
+      run.lastTime = (int) fields[0];
+    run.trace.push_back(Sample{(double) run.lastTime, fields.back()});
+    return;
+  }
+
+  // Phase changes, learning adjustments and warnings
+  if (startsWith(line, "******* Phase: "))
+    run.events.push_back(Event{run.lastTime, "Phase: " + line.substr(15, line.find(" *******", 15) - 15)});
+  else if (line == "Move to bake phase")
+    run.events.push_back(Event{run.lastTime, "Phase: Baking"});
+  else if (line == "Starting cooling")
+    run.events.push_back(Event{run.lastTime, "Phase: Cooling"});
+  else if (line == "Reflow is done!" || line == "Bake is done!")
+    run.events.push_back(Event{run.lastTime, "Done"});
+  else if (startsWith(line, "Adjusting duty cycles") || line.find(" changed from ") != std::string::npos ||
+           startsWith(line, "Warning:") || startsWith(line, "Duty cycles lowered") || startsWith(line, "Duty cycles increased") || startsWith(line, "Aborting"))
+    run.events.push_back(Event{run.lastTime, line});
+}
+
+
+static boolean readLog(const char *filename, Run &run) {
+  FILE *file = fopen(filename, "r");
+  char buffer[512];
+
+  if (!file)
+    return false;
+  while (fgets(buffer, sizeof(buffer), file)) {
+    buffer[strcspn(buffer, "\r\n")] = 0;
+    addLine(run, buffer);
+  }
+  fclose(file);
+  return !run.trace.empty();
+}
+
+
+// Find the last value of a line like "Baking temperature = 120"
+static boolean findSetting(const Run &run, const char *prefix, int &value) {
+  boolean found = false;
+  for (size_t i=0; i<run.lines.size(); i++) {
+    if (startsWith(run.lines[i], prefix)) {
+      value = atoi(run.lines[i].c_str() + strlen(prefix));
+      found = true;
+    }
+  }
+  return found;
+}
+
+
+// Set up the EEPROM with the oven configuration printed at the start of each phase in the log
+static void configureFromLog(const Run &run) {
+  int value, phase = -1;
+
+  for (size_t i=0; i<run.lines.size(); i++) {
+    const std::string &line = run.lines[i];
+    if (startsWith(line, "******* Phase: ")) {
+      phase = -1;
+      for (int p=PHASE_PRESOAK; p<=PHASE_REFLOW; p++)
+        if (line.find(getDescription(phaseDescription, p)) == 15)
+          phase = p;
+    }
+    // The reflow phase ends at the maximum temperature
+    if (phase == PHASE_REFLOW && startsWith(line, "End temperature = "))
+      EEPROM.write(SETTING_MAX_TEMPERATURE, atoi(line.c_str() + 18) - TEMPERATURE_OFFSET);
+    // Duty cycles look like "  D4 = 50  (Top)"
+    int output, duty;
+    char type[20];
+    if (phase != -1 && sscanf(line.c_str(), "  D%d = %d  (%19[^)])", &output, &duty, type) == 3 && output >= 4 && output <= 7) {
+      EEPROM.write(SETTING_PRESOAK_D4_DUTY_CYCLE + (phase - PHASE_PRESOAK) * 4 + output - 4, duty);
+      for (int t=0; t<NO_OF_TYPES; t++)
+        if (strcmp(type, getDescription(outputDescription, t)) == 0)
+          EEPROM.write(SETTING_D4_TYPE + output - 4, t);
+      EEPROM.write(SETTING_SETTINGS_CHANGED, false);
+    }
+    if (line == "Learning mode is enabled.  Duty cycles may be adjusted automatically if necessary")
+      EEPROM.write(SETTING_LEARNING_MODE, true);
+  }
+
+  if (findSetting(run, "Baking temperature = ", value))
+    setSetting(SETTING_BAKE_TEMPERATURE, value);
+  if (findSetting(run, "Baking duration = ", value)) {
+    for (int i=0; i<BAKE_MAX_DURATION; i++)
+      if (getBakeSeconds(i) == value)
+        setSetting(SETTING_BAKE_DURATION, i);
+  }
+}
+
+
+// ***** Replay *****
+
+static Run original, replayed;
+static boolean traceStarted = false;
+static unsigned long traceStartMillis;
+static unsigned long lastPinUpdateMillis;
+static std::string currentPhase = "Init";
+static std::vector<std::string> phaseOrder;
+static std::map<std::string, unsigned long> phaseMillis;
+static std::map<std::string, unsigned long> outputOnMillis[4];
+static boolean verbose = false;
+
+
+// The recorded temperature at the current simulated time
+static double recordedTemperature() {
+  double t = traceStarted? (millis() - traceStartMillis) / 1000.0 : 0;
+  const std::vector<Sample> &trace = original.trace;
+  if (t <= trace.front().time)
+    return trace.front().temperature;
+  for (size_t i=1; i<trace.size(); i++) {
+    if (trace[i].time >= t) {
+      double fraction = (t - trace[i-1].time) / (trace[i].time - trace[i-1].time);
+      return trace[i-1].temperature + fraction * (trace[i].temperature - trace[i-1].temperature);
+    }
+  }
+
+  // The log stops at the sample before the one that ended the run, so continue the trend for a
+  // few seconds.  After that, hold the last temperature
+  if (trace.size() < 2)
+    return trace.back().temperature;
+  const Sample &last = trace[trace.size() - 1], &previous = trace[trace.size() - 2];
+  double slope = (last.temperature - previous.temperature) / (last.time - previous.time);
+  return last.temperature + slope * min(t - last.time, (double) REPLAY_EXTRAPOLATION);
+}
+
+
+// The air thermocouple follows the recording.  There is a board MAX31855, but no thermocouple
+// is attached to it
+boolean replayThermocoupleFrame(uint8_t csPin, uint32_t *frame) {
+  if (csPin == MAX31855_DEFAULT_CS_PIN)
+    *frame = replayEncodeThermocoupleFrame(recordedTemperature());
+  else if (csPin == BOARD_THERMOCOUPLE_CS_PIN)
+    *frame = replayEncodeThermocoupleFrame(NAN);
+  else
+    return false;
+  return true;
+}
+
+
+// Add up the time each output was on, in each phase
+static void updateOutputTimes() {
+  unsigned long now = millis();
+  for (int i=0; i<4; i++)
+    if (replayPinLevel[4 + i])
+      outputOnMillis[i][currentPhase] += now - lastPinUpdateMillis;
+  phaseMillis[currentPhase] += now - lastPinUpdateMillis;
+  lastPinUpdateMillis = now;
+}
+
+
+void replayPinChanged(uint8_t pin, uint8_t /* value */) {
+  if (pin >= 4 && pin <= 7)
+    updateOutputTimes();
+}
+
+
+void replaySerialLine(const char *line) {
+  size_t events = replayed.events.size();
+
+  if (verbose)
+    printf("%8.2f  %s\n", millis() / 1000.0, line);
+
+  // The reflow starts when the first phase is displayed
+  if (!traceStarted && startsWith(line, "******* Phase: ")) {
+    traceStarted = true;
+    traceStartMillis = millis();
+  }
+
+  addLine(replayed, line);
+
+  // Keep track of the phase, for the output duty cycles
+  if (replayed.events.size() != events && startsWith(replayed.events.back().text, "Phase: ")) {
+    updateOutputTimes();
+    currentPhase = replayed.events.back().text.substr(7);
+    phaseOrder.push_back(currentPhase);
+  }
+}
+
+
+static void usage() {
+  fprintf(stderr,
+    "Usage: replay [options] logfile\n"
+    "  -e file    Load the EEPROM from a 1024-byte image before applying the log's configuration\n"
+    "  -w file    Save the EEPROM to a 1024-byte image after the replay (for replaying the next run)\n"
+    "  -n         Don't configure the oven from the log (use the EEPROM image as-is)\n"
+    "  -o types   Override the output types for D4-D7, one letter each from U(nused), T(op),\n"
+    "             B(ottom), X (boost), C(onvection fan) or F (cooling fan).  For example: BTCU\n"
+    "  -m temp    Override the maximum temperature\n"
+    "  -l 0|1     Override learning mode\n"
+    "  -t secs    Tolerance when comparing event times (default 2)\n"
+    "  -v         Print the replayed serial output\n"
+    "Returns 0 if the replay matches the original log, 1 if it doesn't, 2 on error\n");
+}
+
+
+int main(int argc, char *argv[]) {
+  const char *eepromIn = 0, *eepromOut = 0, *logFile = 0, *outputTypes = 0;
+  int maxTemperature = 0, learningMode = -1, tolerance = 2;
+  boolean useLogConfig = true;
+  int dutyCyclesBefore[12], bakeDutyCycleBefore;
+
+  for (int i=1; i<argc; i++) {
+    if (!strcmp(argv[i], "-e") && i+1 < argc) eepromIn = argv[++i];
+    else if (!strcmp(argv[i], "-w") && i+1 < argc) eepromOut = argv[++i];
+    else if (!strcmp(argv[i], "-n")) useLogConfig = false;
+    else if (!strcmp(argv[i], "-o") && i+1 < argc && strlen(argv[i+1]) == 4) outputTypes = argv[++i];
+    else if (!strcmp(argv[i], "-m") && i+1 < argc) maxTemperature = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-l") && i+1 < argc) learningMode = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-t") && i+1 < argc) tolerance = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-v")) verbose = true;
+    else if (argv[i][0] != '-' && !logFile) logFile = argv[i];
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (!logFile) {
+    usage();
+    return 2;
+  }
+
+  original.lastDuty = replayed.lastDuty = -1;
+  if (!readLog(logFile, original)) {
+    fprintf(stderr, "No temperature samples found in %s\n", logFile);
+    return 2;
+  }
+
+  // Start with an erased EEPROM, or the given image
+  memset(EEPROM.data, 0xFF, sizeof(EEPROM.data));
+  if (eepromIn) {
+    FILE *file = fopen(eepromIn, "rb");
+    if (!file || fread(EEPROM.data, 1, EEPROM_SIZE, file) != EEPROM_SIZE) {
+      fprintf(stderr, "Unable to read EEPROM image %s\n", eepromIn);
+      return 2;
+    }
+    fclose(file);
+  }
+
+  // Start ControLeo2 as usual, then configure the oven
+  setup();
+  // Finish initializing the EEPROM, which the sketch does in the background behind the splash screen
+  while (!continueSettingsInitialization())
+    ;
+  if (useLogConfig)
+    configureFromLog(original);
+  if (outputTypes) {
+    for (int i=0; i<4; i++) {
+      const char *type = strchr(OUTPUT_TYPE_LETTERS, toupper(outputTypes[i]));
+      if (!type || !*type) {
+        usage();
+        return 2;
+      }
+      EEPROM.write(SETTING_D4_TYPE + i, type - OUTPUT_TYPE_LETTERS);
+    }
+  }
+  if (maxTemperature)
+    EEPROM.write(SETTING_MAX_TEMPERATURE, maxTemperature - TEMPERATURE_OFFSET);
+  if (learningMode != -1)
+    EEPROM.write(SETTING_LEARNING_MODE, learningMode);
+  for (int i=0; i<12; i++)
+    dutyCyclesBefore[i] = getSetting(SETTING_PRESOAK_D4_DUTY_CYCLE + i);
+  bakeDutyCycleBefore = getLearnedBakeDutyCycle(getSetting(SETTING_BAKE_TEMPERATURE));
+
+  // Run the reflow or bake, the same way the main loop does
+  if (original.isBake) {
+    // Bakes start heating straight away, without displaying the phase
+    traceStarted = true;
+    traceStartMillis = millis();
+    currentPhase = "Heating";
+    phaseOrder.push_back(currentPhase);
+  }
+  lastPinUpdateMillis = millis();
+  unsigned long nextLoopTime = millis() + 50;
+  boolean finished = false;
+  while (!(finished = !(original.isBake? Bake() : Reflow()))) {
+    if (millis() < nextLoopTime)
+      delay(nextLoopTime - millis());
+    nextLoopTime += 50;
+    if (traceStarted && millis() - traceStartMillis > (original.trace.back().time + REPLAY_TIMEOUT) * 1000)
+      break;
+  }
+  updateOutputTimes();
+  if (!finished)
+    replayed.events.push_back(Event{replayed.lastTime, "Did not finish"});
+
+  // Compare the events.  Events are matched by their text and how many times they have occurred
+  int differences = 0;
+  std::map<std::string, int> seen;
+  std::vector<boolean> matched(replayed.events.size(), false);
+  printf("%-60s %8s %8s\n", "Event", "Original", "Replay");
+  for (size_t i=0; i<original.events.size(); i++) {
+    const Event &event = original.events[i];
+    int occurrence = seen[event.text]++, count = 0;
+    size_t j;
+    for (j=0; j<replayed.events.size(); j++)
+      if (replayed.events[j].text == event.text && count++ == occurrence)
+        break;
+    if (j == replayed.events.size()) {
+      printf("%-60s %7ds %8s   <<<\n", event.text.c_str(), event.time, "-");
+      differences++;
+      continue;
+    }
+    matched[j] = true;
+    int delta = replayed.events[j].time - event.time;
+    boolean isDifferent = abs(delta) > tolerance;
+    printf("%-60s %7ds %7ds", event.text.c_str(), event.time, replayed.events[j].time);
+    if (delta)
+      printf(" %+4ds", delta);
+    printf("%s\n", isDifferent? "   <<<" : "");
+    differences += isDifferent;
+  }
+  for (size_t j=0; j<replayed.events.size(); j++) {
+    if (!matched[j]) {
+      printf("%-60s %8s %7ds   <<<\n", replayed.events[j].text.c_str(), "-", replayed.events[j].time);
+      differences++;
+    }
+  }
+
+  // The outputs aren't in the log, so only the replayed ones can be shown
+  printf("\nReplayed output duty cycles (%% of time on)\n%-20s %6s %6s %6s %6s\n", "Phase", "D4", "D5", "D6", "D7");
+  for (size_t p=0; p<phaseOrder.size(); p++) {
+    const std::string &phase = phaseOrder[p];
+    if (std::find(phaseOrder.begin(), phaseOrder.begin() + p, phase) != phaseOrder.begin() + p || !phaseMillis[phase])
+      continue;
+    printf("%-20s", phase.c_str());
+    for (int i=0; i<4; i++)
+      printf(" %5lu%%", outputOnMillis[i][phase] * 100 / phaseMillis[phase]);
+    printf("\n");
+  }
+
+  // Show the learned duty cycles that changed
+  printf("\nLearned duty cycle changes\n");
+  for (int i=0; i<12; i++) {
+    int after = getSetting(SETTING_PRESOAK_D4_DUTY_CYCLE + i);
+    if (after != dutyCyclesBefore[i])
+      printf("  %s D%d: %d -> %d\n", getDescription(phaseDescription, PHASE_PRESOAK + i / 4), 4 + i % 4, dutyCyclesBefore[i], after);
+  }
+  if (original.isBake && getLearnedBakeDutyCycle(getSetting(SETTING_BAKE_TEMPERATURE)) != bakeDutyCycleBefore)
+    printf("  Bake at %d Celsius: %d -> %d\n", getSetting(SETTING_BAKE_TEMPERATURE), bakeDutyCycleBefore, getLearnedBakeDutyCycle(getSetting(SETTING_BAKE_TEMPERATURE)));
+
+  if (eepromOut) {
+    FILE *file = fopen(eepromOut, "wb");
+    if (!file || fwrite(EEPROM.data, 1, EEPROM_SIZE, file) != EEPROM_SIZE) {
+      fprintf(stderr, "Unable to write EEPROM image %s\n", eepromOut);
+      return 2;
+    }
+    fclose(file);
+  }
+
+  printf("\n%s: %d difference%s\n", logFile, differences, differences == 1? "" : "s");
+  return differences? 1 : 0;
+}
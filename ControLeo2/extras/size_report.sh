@@ -0,0 +1,31 @@
+#!/bin/sh
+# Report the RAM and flash used by a ControLeo2 sketch, largest symbols first.
+# The ATmega32U4 only has 2.5Kb of RAM, so check this after making changes.
+#
+# Requires arduino-cli (with the arduino:avr core installed) and avr-nm/avr-size on the path.
+#
+# Usage: size_report.sh [sketch folder] [number of symbols to list]
+#   e.g. size_report.sh ../examples/ReflowWizard 20
+#
+# Released under WTFPL license
+
+SKETCH=${1:-$(dirname "$0")/../examples/ReflowWizard}
+COUNT=${2:-25}
+BUILD=$(mktemp -d)
+
+# The library is the parent of the extras folder
+arduino-cli compile --fqbn arduino:avr:leonardo --library "$(dirname "$0")/.." --build-path "$BUILD" "$SKETCH" > /dev/null || exit 1
+ELF=$(ls "$BUILD"/*.elf)
+
+echo "===== Totals ====="
+avr-size -C --mcu=atmega32u4 "$ELF"
+
+# RAM symbols are initialized (d/D) and uninitialized (b/B) data
+echo "===== RAM (largest $COUNT symbols) ====="
+avr-nm -C -S -t d --size-sort -r "$ELF" | awk '$3 ~ /^[bBdD]$/' | head -n "$COUNT" | awk '{ printf "%6d  %s\n", $2, substr($0, index($0, $4)) }'
+
+# Flash symbols are code (t/T), which includes strings and tables in PROGMEM
+echo "===== Flash (largest $COUNT symbols) ====="
+avr-nm -C -S -t d --size-sort -r "$ELF" | awk '$3 ~ /^[tTwW]$/' | head -n "$COUNT" | awk '{ printf "%6d  %s\n", $2, substr($0, index($0, $4)) }'
+
+rm -rf "$BUILD"